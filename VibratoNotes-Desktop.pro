@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui widgets sql
+QT       += core gui widgets sql concurrent
 
 TARGET = vibrato
 TEMPLATE = app
@@ -36,7 +36,11 @@ SOURCES += \
     $$PWD/src/meta/note.cpp \
     $$PWD/src/meta/notebook.cpp \
     $$PWD/src/meta/tag.cpp \
+    $$PWD/src/meta/nodepool.cpp \
     $$PWD/src/meta/db/notedatabase.cpp \
+    $$PWD/src/meta/db/trigramindex.cpp \
+    $$PWD/src/meta/db/notestore.cpp \
+    $$PWD/src/meta/db/synchashinterner.cpp \
     $$PWD/src/meta/db/notebookdatabase.cpp \
     $$PWD/src/meta/db/tagdatabase.cpp \
     $$PWD/src/models/treemodel.cpp \
@@ -47,6 +51,7 @@ SOURCES += \
     $$PWD/src/meta/db/database.cpp \
     $$PWD/src/models/items/notelistitem.cpp \
     $$PWD/src/models/notelistmodel.cpp \
+    $$PWD/src/models/trashlistmodel.cpp \
     $$PWD/src/models/views/customlistview.cpp \
     $$PWD/ui/note_editnotebook.cpp \
     $$PWD/src/models/items/treeitemwithid.cpp \
@@ -54,14 +59,18 @@ SOURCES += \
     $$PWD/ui/note_edittags.cpp \
     $$PWD/src/models/items/listitemwithid.cpp \
     $$PWD/src/models/sortfilter/notelistproxymodel.cpp \
+    $$PWD/src/models/sortfilter/notesearchengine.cpp \
+    $$PWD/src/models/sortfilter/fuzzymatcher.cpp \
     $$PWD/ui/edittags.cpp \
     $$PWD/src/models/views/customtreeview.cpp \
-    $$PWD/ui/trashitem.cpp \
     $$PWD/src/ui-managers/notelist-views/trashview.cpp \
     $$PWD/src/ui-managers/notelist-views/genericview.cpp \
     $$PWD/ui/notebook_editparent.cpp \
     $$PWD/src/sql/sqlmanager.cpp \
+    $$PWD/src/sql/notesavequeue.cpp \
+    $$PWD/src/sql/storagethread.cpp \
     $$PWD/src/models/delegates/noteitemdelegate.cpp \
+    $$PWD/src/models/delegates/trashitemdelegate.cpp \
     $$PWD/src/custom-components/customlineedit.cpp \
     $$PWD/src/cloud/cloudmanager.cpp \
     $$PWD/src/crypto/vcrypto.cpp \
@@ -77,7 +86,11 @@ HEADERS += \
     $$PWD/src/meta/note.h \
     $$PWD/src/meta/notebook.h \
     $$PWD/src/meta/tag.h \
+    $$PWD/src/meta/nodepool.h \
     $$PWD/src/meta/db/notedatabase.h \
+    $$PWD/src/meta/db/trigramindex.h \
+    $$PWD/src/meta/db/notestore.h \
+    $$PWD/src/meta/db/synchashinterner.h \
     $$PWD/src/meta/db/notebookdatabase.h \
     $$PWD/src/meta/db/tagdatabase.h \
     $$PWD/include/helper-io.hpp \
@@ -89,6 +102,7 @@ HEADERS += \
     $$PWD/src/meta/db/database.h \
     $$PWD/src/models/items/notelistitem.h \
     $$PWD/src/models/notelistmodel.h \
+    $$PWD/src/models/trashlistmodel.h \
     $$PWD/src/models/views/customlistview.h \
     $$PWD/ui/note_editnotebook.h \
     $$PWD/src/models/items/treeitemwithid.h \
@@ -97,14 +111,18 @@ HEADERS += \
     $$PWD/ui/note_edittags.h \
     $$PWD/src/models/items/listitemwithid.h \
     $$PWD/src/models/sortfilter/notelistproxymodel.h \
+    $$PWD/src/models/sortfilter/notesearchengine.h \
+    $$PWD/src/models/sortfilter/fuzzymatcher.h \
     $$PWD/ui/edittags.h \
     $$PWD/src/models/views/customtreeview.h \
-    $$PWD/ui/trashitem.h \
     $$PWD/src/ui-managers/notelist-views/trashview.h \
     $$PWD/src/ui-managers/notelist-views/genericview.h \
     $$PWD/ui/notebook_editparent.h \
     $$PWD/src/sql/sqlmanager.h \
+    $$PWD/src/sql/notesavequeue.h \
+    $$PWD/src/sql/storagethread.h \
     $$PWD/src/models/delegates/noteitemdelegate.h \
+    $$PWD/src/models/delegates/trashitemdelegate.h \
     $$PWD/src/custom-components/customlineedit.h \
     $$PWD/src/cloud/cloudmanager.h \
     $$PWD/src/crypto/vcrypto.h \
@@ -124,7 +142,6 @@ FORMS += \
     $$PWD/ui/note_edittags.ui \
     $$PWD/ui/notelist_addons.ui \
     $$PWD/ui/edittags.ui \
-    $$PWD/ui/trashitem.ui \
     $$PWD/ui/notebook_editparent.ui
 
 include($$PWD/src/text-editor/Escriba.pro)
@@ -25,21 +25,29 @@ public:
     return data_dir;
   }
 
-  // Warning: Returns a char* that must be deleted.
+  // Warning: Returns a char* that must be freed.
   static char *QString2CString(QString str)
   {
-    int len = str.length()+1;
-    char *new_string = static_cast<char*>(malloc(len));
-
-    std::string std_str = str.toStdString();
-
-    for (int i=0; i<len-1; i++)
-      new_string[i] = std_str[i];
-
-    new_string[len-1] = '\0';
+    // The UTF-8 form can be longer than str.length().
+    QByteArray utf8 = str.toUtf8();
+    char *new_string = static_cast<char*>(malloc(utf8.size()+1));
+    memcpy(new_string, utf8.constData(), utf8.size()+1);
     return new_string;
   }
 
+  // UTF-8 form of str for matching searches against: case folded and
+  // without diacritics, so "Élan" and "elan" give the same key.
+  static QByteArray searchKey(const QString &str)
+  {
+    QString decomposed = str.normalized(QString::NormalizationForm_KD);
+    QString key;
+    key.reserve(decomposed.size());
+    for (QChar c : decomposed)
+      if (c.category() != QChar::Mark_NonSpacing)
+        key.append(c);
+    return key.toCaseFolded().toUtf8();
+  }
+
   static QString fileToQString(QString filename)
   {
     QString val;
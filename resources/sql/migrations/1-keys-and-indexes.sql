@@ -0,0 +1,76 @@
+-- Migration 1
+-- Gives every table a proper key, fixes the sync_hash column types
+-- and adds indexes for the lookups Vibrato does all the time.
+-- Sync hashes are stored without braces. The nil UUID (Default Notebook)
+-- is stored as NULL.
+
+CREATE TABLE notes_migrated (
+  sync_hash TEXT PRIMARY KEY NOT NULL,
+  title TEXT,
+  text TEXT,
+  date_created DATETIME,
+  date_modified DATETIME,
+  notebook TEXT REFERENCES notebooks(sync_hash),
+  favorited BOOLEAN,
+  encrypted BOOLEAN,
+  trashed BOOLEAN
+);
+
+INSERT OR IGNORE INTO notes_migrated
+SELECT trim(sync_hash, '{}'), title, text, date_created, date_modified,
+       nullif(trim(notebook, '{}'), '00000000-0000-0000-0000-000000000000'),
+       favorited, encrypted, trashed
+FROM notes WHERE sync_hash IS NOT NULL;
+
+DROP TABLE notes;
+ALTER TABLE notes_migrated RENAME TO notes;
+
+CREATE TABLE notebooks_migrated (
+  sync_hash TEXT PRIMARY KEY NOT NULL,
+  title TEXT,
+  date_modified DATETIME,
+  parent TEXT REFERENCES notebooks(sync_hash),
+  row INTEGER,
+  encrypted BOOLEAN
+);
+
+INSERT OR IGNORE INTO notebooks_migrated
+SELECT trim(sync_hash, '{}'), title, date_modified, nullif(trim(parent, '{}'), ''), row, encrypted
+FROM notebooks WHERE sync_hash IS NOT NULL;
+
+DROP TABLE notebooks;
+ALTER TABLE notebooks_migrated RENAME TO notebooks;
+
+CREATE TABLE tags_migrated (
+  sync_hash TEXT PRIMARY KEY NOT NULL,
+  title TEXT,
+  date_modified DATETIME,
+  row INTEGER,
+  encrypted BOOLEAN
+);
+
+INSERT OR IGNORE INTO tags_migrated
+SELECT trim(sync_hash, '{}'), title, date_modified, row, encrypted
+FROM tags WHERE sync_hash IS NOT NULL;
+
+DROP TABLE tags;
+ALTER TABLE tags_migrated RENAME TO tags;
+
+-- The primary key doubles as the index for looking up a note's tags.
+CREATE TABLE notes_tags_migrated (
+  note TEXT NOT NULL REFERENCES notes(sync_hash),
+  tag TEXT NOT NULL REFERENCES tags(sync_hash),
+  PRIMARY KEY (note, tag)
+) WITHOUT ROWID;
+
+INSERT OR IGNORE INTO notes_tags_migrated
+SELECT trim(note, '{}'), trim(tag, '{}')
+FROM notes_tags WHERE note IS NOT NULL AND tag IS NOT NULL;
+
+DROP TABLE notes_tags;
+ALTER TABLE notes_tags_migrated RENAME TO notes_tags;
+
+-- Covering indexes
+CREATE INDEX notes_tags_by_tag ON notes_tags(tag, note);
+CREATE INDEX notes_by_notebook ON notes(notebook);
+CREATE INDEX notebooks_by_parent ON notebooks(parent, row);
@@ -0,0 +1,56 @@
+-- Migration 2
+-- Full-text index over note titles and bodies. notes_fts doesn't store
+-- a second copy of the text, it reads it from notes by id. The triggers
+-- below keep the index in sync with notes.
+-- Any migration that rebuilds the notes table must also run
+-- INSERT INTO notes_fts(notes_fts) VALUES ('rebuild').
+
+-- notes_fts needs an INTEGER PRIMARY KEY to point at. The implicit rowid
+-- of a table keyed on a TEXT column may be renumbered by VACUUM, which
+-- would leave the index matching the wrong notes.
+CREATE TABLE notes_migrated (
+  id INTEGER PRIMARY KEY,
+  sync_hash TEXT UNIQUE NOT NULL,
+  title TEXT,
+  text TEXT,
+  date_created DATETIME,
+  date_modified DATETIME,
+  notebook TEXT REFERENCES notebooks(sync_hash),
+  favorited BOOLEAN,
+  encrypted BOOLEAN,
+  trashed BOOLEAN
+);
+
+INSERT INTO notes_migrated (sync_hash, title, text, date_created, date_modified,
+                            notebook, favorited, encrypted, trashed)
+SELECT sync_hash, title, text, date_created, date_modified,
+       notebook, favorited, encrypted, trashed
+FROM notes ORDER BY rowid;
+
+DROP TABLE notes;
+ALTER TABLE notes_migrated RENAME TO notes;
+
+CREATE INDEX notes_by_notebook ON notes(notebook);
+
+CREATE VIRTUAL TABLE notes_fts USING fts5(
+  title,
+  text,
+  content='notes',
+  content_rowid='id',
+  tokenize='unicode61 remove_diacritics 1'
+);
+
+INSERT INTO notes_fts(notes_fts) VALUES ('rebuild');
+
+CREATE TRIGGER notes_fts_insert AFTER INSERT ON notes BEGIN
+  INSERT INTO notes_fts(rowid, title, text) VALUES (new.id, new.title, new.text);
+END;
+
+CREATE TRIGGER notes_fts_delete AFTER DELETE ON notes BEGIN
+  INSERT INTO notes_fts(notes_fts, rowid, title, text) VALUES ('delete', old.id, old.title, old.text);
+END;
+
+CREATE TRIGGER notes_fts_update AFTER UPDATE OF title, text ON notes BEGIN
+  INSERT INTO notes_fts(notes_fts, rowid, title, text) VALUES ('delete', old.id, old.title, old.text);
+  INSERT INTO notes_fts(rowid, title, text) VALUES (new.id, new.title, new.text);
+END;
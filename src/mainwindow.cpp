@@ -15,6 +15,7 @@ MainWindow::MainWindow(QWidget *parent) :
   ui->setupUi(this);
 
   m_sqlManager        = new SQLManager();
+  m_sqlManager->startStorageThread();
   m_notes     = new NoteDatabase(m_sqlManager);
   m_notebooks = new NotebookDatabase(m_sqlManager, m_notes);
   m_tags      = new TagDatabase(m_sqlManager);
@@ -111,12 +112,15 @@ MainWindow::~MainWindow()
   delete m_escriba_manager;
   delete m_notes;
   delete m_notebooks;
+  delete m_tags;
+  delete m_sqlManager; // Commits any remaining writes
   delete ui;
 }
 
 void MainWindow::closeEvent (QCloseEvent *event)
 {
   m_user_window.close();
+  m_notes->flushChanges();
   event->accept();
 }
 
@@ -7,9 +7,10 @@
 
 NotebookDatabase::NotebookDatabase(SQLManager *sqlManager, NoteDatabase *noteDatabase) :
   m_sqlManager(sqlManager),
+  m_defaultNotebook(QUuid(), "Default Notebook"),
   m_noteDatabase(noteDatabase)
 {
-  addNotebook(new Notebook(nullptr, "Default Notebook"));
+  addNotebook(&m_defaultNotebook);
   loadSQL();
 }
 
@@ -26,7 +27,8 @@ int NotebookDatabase::size() const
 
 QVector<Notebook *> NotebookDatabase::listRecursively() const
 {
-  return listRecursively(m_list);
+  rebuildTree();
+  return m_preOrder;
 }
 
 QVector<Notebook*> NotebookDatabase::listRecursively(const QVector<Notebook*> notebookList) const
@@ -46,6 +48,7 @@ void NotebookDatabase::addNotebook(Notebook *notebook)
 {
   if (notebook->parent() == nullptr)
     m_list.append(notebook);
+  invalidateTree();
   connectNotebook(notebook);
   emit added(notebook);
 }
@@ -53,7 +56,7 @@ void NotebookDatabase::addNotebook(Notebook *notebook)
 void NotebookDatabase::addNotebook(Notebook *notebook, Notebook *parent)
 {
   notebook->setParent(parent);
-  m_sqlManager->addNotebook(notebook);
+  m_sqlManager->postAddNotebook(notebook);
   if (parent != nullptr)
     parent->addChild(notebook);
   addNotebook(notebook);
@@ -140,10 +143,11 @@ void NotebookDatabase::removeNotebook(Notebook *notebook)
   else
     notebook->parent()->removeChild(notebook);
 
-  m_sqlManager->deleteNotebook(notebook);
+  m_sqlManager->postDeleteNotebook(notebook->syncHash());
 
   // Free memory and emit a notebooksRemoved event.
-  delete notebook;
+  deleteNotebookTree(notebook);
+  invalidateTree();
   emit removed( the_sync_hashes );
 }
 
@@ -157,18 +161,123 @@ void NotebookDatabase::clearNotebooks()
     for ( Notebook *child : notebook->recurseChildren() )
       the_ids.append( child->syncHash() );
     emit removed( the_ids );
-    delete notebook;
+    deleteNotebookTree(notebook);
     m_list.removeAt(i);
   }
+  invalidateTree();
+  Notebook::releasePool();
 }
 
 Notebook *NotebookDatabase::findNotebookWithSyncHash(QUuid syncHash)
 {
-  for (Notebook *notebook : listRecursively()) {
-    if (notebook->syncHash() == syncHash)
-      return notebook;
+  rebuildTree();
+  int position = preOrderPosition(syncHash);
+  return position >= 0 ? m_preOrder.at(position) : nullptr;
+}
+
+bool NotebookDatabase::notebookContains(Notebook *ancestor, QUuid notebookSyncHash) const
+{
+  SyncHashInterner::Id id = syncHashInterner()->id(notebookSyncHash);
+  // Sync hashes that were never interned belong to no notebook.
+  if ( id == 0 && !notebookSyncHash.isNull() )
+    return false;
+  return notebookContains(ancestor, id);
+}
+
+bool NotebookDatabase::notebookContains(Notebook *ancestor, SyncHashInterner::Id notebookId) const
+{
+  SyncHashInterner::Id ancestorId = syncHashInterner()->id(ancestor->syncHash());
+  if ( ancestorId == 0 && !ancestor->syncHash().isNull() )
+    return false;
+  return notebookContains(ancestorId, notebookId);
+}
+
+bool NotebookDatabase::notebookContains(SyncHashInterner::Id ancestorId, SyncHashInterner::Id notebookId) const
+{
+  rebuildTree();
+  // Ids of deleted notebooks have no position, so they contain nothing.
+  int first = preOrderPosition(ancestorId);
+  int position = preOrderPosition(notebookId);
+  if ( first < 0 || position < 0 )
+    return false;
+  return position >= first && position < m_subtreeEnds.at(first);
+}
+
+int NotebookDatabase::preOrderPosition(QUuid syncHash) const
+{
+  SyncHashInterner::Id id = syncHashInterner()->id(syncHash);
+  if ( id == 0 && !syncHash.isNull() )
+    return -1;
+  return preOrderPosition(id);
+}
+
+int NotebookDatabase::preOrderPosition(SyncHashInterner::Id id) const
+{
+  if ( id >= static_cast<SyncHashInterner::Id>(m_preOrderPositions.size()) )
+    return -1;
+  return m_preOrderPositions.at(id);
+}
+
+QVector<QUuid> NotebookDatabase::subtreeSyncHashes(Notebook *notebook) const
+{
+  rebuildTree();
+  QVector<QUuid> syncHashes;
+  int first = preOrderPosition(notebook->syncHash());
+  if ( first < 0 || m_preOrder.at(first) != notebook )
+    return syncHashes;
+  for (int i = first; i < m_subtreeEnds.at(first); i++)
+    syncHashes.append( m_preOrder.at(i)->syncHash() );
+  return syncHashes;
+}
+
+void NotebookDatabase::invalidateTree()
+{
+  m_treeDirty = true;
+}
+
+void NotebookDatabase::rebuildTree() const
+{
+  if ( !m_treeDirty )
+    return;
+
+  m_preOrder.clear();
+  m_subtreeEnds.clear();
+  m_preOrderPositions.fill(-1);
+
+  // Iterative pre-order walk. A notebook is visited a second time, with
+  // its position, once all of its children are done. That closes its range.
+  QVector<QPair<Notebook*, int>> stack;
+  for (int i = m_list.size()-1; i >= 0; i--)
+    stack.append( qMakePair(m_list.at(i), -1) );
+
+  while ( !stack.isEmpty() ) {
+    QPair<Notebook*, int> top = stack.takeLast();
+    Notebook *notebook = top.first;
+    if ( top.second >= 0 ) {
+      m_subtreeEnds[top.second] = m_preOrder.size();
+      continue;
+    }
+    SyncHashInterner::Id id = syncHashInterner()->intern(notebook->syncHash());
+    while ( id >= static_cast<SyncHashInterner::Id>(m_preOrderPositions.size()) )
+      m_preOrderPositions.append(-1);
+    m_preOrderPositions[id] = m_preOrder.size();
+    stack.append( qMakePair(notebook, m_preOrder.size()) );
+    m_preOrder.append(notebook);
+    m_subtreeEnds.append(m_preOrder.size());
+
+    QVector<Notebook*> children = notebook->children();
+    for (int i = children.size()-1; i >= 0; i--)
+      stack.append( qMakePair(children.at(i), -1) );
   }
-  return nullptr;
+  m_treeDirty = false;
+}
+
+void NotebookDatabase::deleteNotebookTree(Notebook *notebook)
+{
+  // Children aren't QObject children of their parent, so they have to be
+  // freed by hand. Once every notebook is gone the pool drops its memory.
+  qDeleteAll( notebook->recurseChildren() );
+  delete notebook;
 }
 
 void NotebookDatabase::loadSQL()
@@ -186,12 +295,13 @@ void NotebookDatabase::loadSQL()
 
 void NotebookDatabase::changed_slot(Notebook *notebook)
 {
-  m_sqlManager->updateNotebookToDB(notebook);
+  m_sqlManager->postUpdateNotebook(notebook);
   emit changed(notebook);
 }
 
 void NotebookDatabase::syncHashChanged_slot(Notebook *notebook)
 {
+  invalidateTree();
   emit syncHashChanged(notebook);
 }
 
@@ -208,29 +318,22 @@ void NotebookDatabase::parentChanged_slot(Notebook *notebook)
        !m_list.contains(notebook) ) {
     m_list.append(notebook);
   }
+  invalidateTree();
   emit parentChanged(notebook);
 }
 
 void NotebookDatabase::childrenChanged_slot(Notebook *notebook)
 {
+  invalidateTree();
   emit childrenChanged(notebook);
 }
 
 void NotebookDatabase::handleNotebookParentRequest(Notebook *notebook, QUuid parentSyncHash)
 {
-  for (Notebook *n : listRecursively()) {
-    if (n->syncHash() == parentSyncHash) {
-      QVector<QUuid> sync_hash_blacklist = {notebook->syncHash()};
-      for (Notebook *child : notebook->recurseChildren())
-        sync_hash_blacklist.append(child->syncHash());
-      // If not a child of notebook, change parent
-      if ( !sync_hash_blacklist.contains(n->syncHash()) ) {
-        n->addChild(notebook);
-        return;
-      }
-    }
-  }
-
+  Notebook *n = findNotebookWithSyncHash(parentSyncHash);
+  // If not a child of notebook, change parent
+  if ( n != nullptr && !notebookContains(notebook, parentSyncHash) )
+    n->addChild(notebook);
 }
 
 void NotebookDatabase::connectNotebook(Notebook *notebook)
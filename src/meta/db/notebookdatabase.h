@@ -1,8 +1,10 @@
 #ifndef NOTEBOOKDATABASE_H
 #define NOTEBOOKDATABASE_H
 #include <QVector>
+#include <QHash>
 #include "../notebook.h"
 #include "notedatabase.h"
+#include "synchashinterner.h"
 #include "../../sql/sqlmanager.h"
 
 class NotebookDatabase : public QObject
@@ -25,6 +27,15 @@ public:
 
   Notebook *findNotebookWithSyncHash(QUuid syncHash);
 
+  // Subtree queries, answered from a cached pre-order walk of the notebook
+  // tree. A notebook's subtree is a contiguous range of that walk.
+  // Callers that may outlive a notebook, like the note list filter, should
+  // hold on to its interned id rather than to the notebook.
+  bool notebookContains(Notebook *ancestor, QUuid notebookSyncHash) const;
+  bool notebookContains(Notebook *ancestor, SyncHashInterner::Id notebookId) const;
+  bool notebookContains(SyncHashInterner::Id ancestorId, SyncHashInterner::Id notebookId) const;
+  QVector<QUuid> subtreeSyncHashes(Notebook *notebook) const;
+
   void loadSQL();
 
   void connectNotebook(Notebook *notebook);
@@ -54,8 +65,24 @@ signals:
 private:
   SQLManager *m_sqlManager;
   QVector<Notebook*> m_list;
+  // Lives as long as the database, outside the notebook pool, so it
+  // doesn't keep the pool from being released by clearNotebooks.
+  Notebook m_defaultNotebook;
   NoteDatabase *m_noteDatabase;
 
+  // Pre-order walk of every notebook, rebuilt lazily after the tree changes.
+  mutable bool m_treeDirty=true;
+  mutable QVector<Notebook*> m_preOrder;
+  mutable QVector<int> m_subtreeEnds; // By pre-order position, one past the subtree
+  mutable QVector<int> m_preOrderPositions; // By interned sync hash, -1 if none
+
+  int preOrderPosition(QUuid syncHash) const;
+  int preOrderPosition(SyncHashInterner::Id id) const;
+
+  void invalidateTree();
+  void rebuildTree() const;
+
+  void deleteNotebookTree(Notebook *notebook);
 };
 
 #endif // NOTEBOOKDATABASE_H
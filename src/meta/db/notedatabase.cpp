@@ -3,17 +3,31 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QUuid>
+#include <QSet>
+#include <algorithm>
 
 #include "notedatabase.h"
+#include "../info/appconfig.h"
 
 #include <helper-io.hpp>
 
 NoteDatabase::NoteDatabase(SQLManager *sqlManager) :
-  m_sqlManager(sqlManager)
+  m_sqlManager(sqlManager),
+  m_saveQueue(new NoteSaveQueue(sqlManager, this)),
+  m_latestBodySearch(new QAtomicInt(0))
 {
+  m_textMemoryBudget = config()->value(NOTE_TEXT_MEMORY_BUDGET, NOTE_TEXT_DEFAULT_MEMORY_BUDGET).toLongLong();
+  qRegisterMetaType<NoteBodySearch>();
+  connect(m_sqlManager, &SQLManager::committed,
+          this, &NoteDatabase::bodySearchCommitted);
   loadSQL();
 }
 
+NoteDatabase::~NoteDatabase()
+{
+  flushChanges();
+}
+
 QList<Note *> NoteDatabase::list() const
 {
   return m_list;
@@ -27,18 +41,64 @@ int NoteDatabase::size() const
 Note *NoteDatabase::addNote(Note *note, bool addToSQL)
 {
   m_list.prepend(note);
+  attachNote(note, addToSQL);
+
+  emit noteAdded(note);
+  return note;
+}
+
+QVector<Note*> NoteDatabase::addNotes(QVector<Note*> notes, bool addToSQL)
+{
+  if ( notes.isEmpty() )
+    return notes;
+
+  // Same order as adding them one by one (newest first), but the
+  // list is only rebuilt once.
+  QList<Note*> list;
+  list.reserve(notes.size() + m_list.size());
+  for (int i = notes.size()-1; i >= 0; i--)
+    list.append(notes.at(i));
+  list.append(m_list);
+  m_list = list;
+
+  for (Note *note : notes)
+    attachNote(note, addToSQL);
 
-  if (addToSQL) m_sqlManager->addNote(note);
+  emit notesAdded(notes);
+  return notes;
+}
+
+// Indexes the note and starts listening to it. It must already be in m_list.
+void NoteDatabase::attachNote(Note *note, bool addToSQL)
+{
+  indexNote(note);
+
+  if (addToSQL) m_sqlManager->postAddNote(note);
 
   connect(note, &Note::changed,
           this, &NoteDatabase::slot_noteChanged);
   connect(note, &Note::favoritedChanged,
           this, &NoteDatabase::handleNoteFavoritedChanged);
   connect(note, &Note::trashedOrRestored,
-          this, &NoteDatabase::noteTrashedOrRestored);
+          this, &NoteDatabase::handleNoteTrashedOrRestored);
+  connect(note, &Note::textRequested,
+          this, &NoteDatabase::loadNoteText);
+  connect(note, &Note::textChanged,
+          this, &NoteDatabase::touchNoteText);
+  connect(note, &Note::syncHashChanged,
+          this, &NoteDatabase::reindexNote);
+  connect(note, &Note::notebookChanged,
+          this, &NoteDatabase::reindexNoteNotebook);
+  connect(note, &Note::tagsChanged,
+          this, &NoteDatabase::reindexNoteTags);
+  connect(note, &Note::titleChanged,
+          this, &NoteDatabase::markNoteTrigramsDirty);
+  connect(note, &Note::textChanged,
+          this, &NoteDatabase::markNoteTrigramsDirty);
 
-  emit noteAdded(note);
-  return note;
+  if ( note->textLoaded() )
+    touchNoteText(note);
+  markNoteTrigramsDirty(note);
 }
 
 Note *NoteDatabase::addDefaultNote()
@@ -50,91 +110,556 @@ Note *NoteDatabase::addDefaultNote()
 void NoteDatabase::removeNote(int index)
 {
   Note *note = m_list[index];
-  QUuid syncHash = note->syncHash();
   m_list.removeAt(index);
-  m_sqlManager->deleteNote(note);
-  delete note;
-  emit noteDeleted(syncHash);
+  m_sqlManager->postDeleteNote(note->syncHash());
+  releaseNote(note);
 }
 
 void NoteDatabase::removeNote(Note *note)
 {
-  int index = m_list.indexOf( note );
-  if ( index >= 0)
-    removeNote( index );
+  if ( m_indexedNotes.contains(note) )
+    removeNotes({note});
   else
     qDebug() << "Tried to remove a note with an ID of -1 :" << note->title();
 }
 
 void NoteDatabase::removeNotes(QVector<Note*> notes)
 {
+  QSet<Note*> removed;
+  for (Note *note : notes)
+    if ( m_indexedNotes.contains(note) )
+      removed.insert(note);
+  if ( removed.isEmpty() )
+    return;
+
+  // Take all of them out of the list in a single pass.
+  m_list.erase( std::remove_if(m_list.begin(), m_list.end(),
+                               [&removed](Note *note) { return removed.contains(note); }),
+                m_list.end() );
+
+  // And out of SQL in a single transaction.
+  QVector<QUuid> syncHashes;
+  syncHashes.reserve(removed.size());
+  for (Note *note : removed)
+    syncHashes.append(note->syncHash());
+  m_sqlManager->postDeleteNotes(syncHashes);
+
+  QVector<Note*> released;
+  released.reserve(removed.size());
+  for (Note *note : notes)
+    if ( removed.remove(note) )
+      released.append(note);
+  emit notesAboutToBeDeleted(released);
+  for (Note *note : released)
+    releaseNote(note);
+}
+
+void NoteDatabase::restoreNotes(QVector<Note*> notes)
+{
+  QVector<Note*> restored;
   for (Note *note : notes)
-    removeNote(note);
+    if ( m_trashedNotes.contains(note) && !restored.contains(note) )
+      restored.append(note);
+  if ( restored.isEmpty() )
+    return;
+
+  // Restoring queues each note to be saved on its own. Save them
+  // together instead.
+  for (Note *note : restored) {
+    note->setTrashed(false);
+    m_saveQueue->remove(note);
+  }
+  m_sqlManager->postUpdateNotes(restored);
+}
+
+// Frees a note that has already been taken out of m_list and SQL.
+void NoteDatabase::releaseNote(Note *note)
+{
+  QUuid syncHash = note->syncHash();
+  unindexNoteTrigrams(note);
+  m_saveQueue->remove(note);
+  forgetNoteText(note);
+  // Listeners may still look up the note's store row.
+  emit noteAboutToBeDeleted(note);
+  unindexNote(note);
+  delete note;
+  emit noteDeleted(syncHash);
 }
 
 void NoteDatabase::clearNotes()
 {
-  for (int i = m_list.size()-1; i >= 0; i--) {
-    removeNote(i);
-  }
+  removeNotes( m_list.toVector() );
 }
 
 void NoteDatabase::loadSQL()
 {
-  QVector<Note*> notes = m_sqlManager->notes();
-  for (Note *note : notes)
-    addNote(note, false);
+  addNotes(m_sqlManager->notes(true), false);
 }
 
 void NoteDatabase::removeNotesWithNotebookSyncHash(QUuid notebookSyncHash)
 {
-  for (Note *note : m_list)
-    if (note->notebook() == notebookSyncHash)
-      removeNote(note);
+  removeNotesWithNotebookSyncHashes({notebookSyncHash});
 }
 
 void NoteDatabase::removeNotesWithNotebookSyncHashes(QVector<QUuid> notebookSyncHashes)
 {
-  for (Note *note : m_list)
-    if ( notebookSyncHashes.contains(note->notebook()) )
-      removeNote(note);
+  removeNotes( findNotesWithNotebookIDs(notebookSyncHashes) );
 }
 
 void NoteDatabase::removeTagFromNotes(QUuid tagSyncHash) {
-  // Loop through each note's list of tags.
-  // If note contains the deleted tag,
-  // Remove the tag from the note.
-  for (Note *note : m_list) {
-    if ( note->tags().contains(tagSyncHash) ) {
-      QVector<QUuid> newTagList = note->tags();
-      newTagList.removeAll(tagSyncHash);
-      note->setTags( newTagList );
-    }
+  // Remove the deleted tag from each note that has it.
+  // Setting the tags updates m_tagIndex, so loop over a copy.
+  QSet<Note*> notes = notesWithTag(tagSyncHash);
+  for (Note *note : notes) {
+    QVector<QUuid> newTagList = note->tags();
+    newTagList.removeAll(tagSyncHash);
+    note->setTags( newTagList );
   }
 }
 
-QVector<Note*> NoteDatabase::findNotesWithNotebookIDs(QVector<QUuid> notebookUUIDs)
+QVector<Note*> NoteDatabase::findNotesWithNotebookIDs(QVector<QUuid> notebookUUIDs) const
 {
   QVector<Note*> notes;
-  for ( Note *note : m_list )
-    if ( notebookUUIDs.contains(note->notebook()) )
+  for ( Id notebook : knownIds(notebookUUIDs) )
+    for ( Note *note : m_notebookIndex.value(notebook) )
       notes.append(note);
   return notes;
 }
 
+int NoteDatabase::countNotesWithNotebookIDs(QVector<QUuid> notebookUUIDs) const
+{
+  int count = 0;
+  for ( Id notebook : knownIds(notebookUUIDs) )
+    count += m_notebookIndex.value(notebook).size();
+  return count;
+}
+
+QSet<Note*> NoteDatabase::notesWithTag(QUuid tagSyncHash) const
+{
+  if ( tagSyncHash.isNull() )
+    return QSet<Note*>();
+  return m_tagIndex.value( syncHashInterner()->id(tagSyncHash) );
+}
+
+QSet<Note*> NoteDatabase::favoritedNotes() const
+{
+  return m_favoritedNotes;
+}
+
+QSet<Note*> NoteDatabase::trashedNotes() const
+{
+  return m_trashedNotes;
+}
+
 bool NoteDatabase::noteWithSyncHashExists(QUuid syncHash) const
 {
-  for (Note *note : m_list)
-    if (note->syncHash() == syncHash)
-      return true;
-  return false;
+  return m_syncHashIndex.contains(syncHash);
+}
+
+Note *NoteDatabase::findNoteWithSyncHash(QUuid syncHash) const
+{
+  return m_syncHashIndex.value(syncHash, nullptr);
+}
+
+void NoteDatabase::indexNote(Note *note)
+{
+  IndexedNote indexed;
+  indexed.syncHash = note->syncHash();
+  indexed.tags = internAll(note->tags());
+  indexed.notebook = m_store.notebook( m_store.insert(note, indexed.tags) );
+  m_indexedNotes.insert(note, indexed);
+
+  m_syncHashIndex.insert(indexed.syncHash, note);
+  m_notebookIndex[indexed.notebook].insert(note);
+  for ( Id tag : indexed.tags )
+    m_tagIndex[tag].insert(note);
+  if ( note->favorited() )
+    m_favoritedNotes.insert(note);
+  if ( note->trashed() )
+    m_trashedNotes.insert(note);
+}
+
+void NoteDatabase::unindexNote(Note *note)
+{
+  IndexedNote indexed = m_indexedNotes.take(note);
+  m_store.remove(m_store.row(note));
+
+  if ( m_syncHashIndex.value(indexed.syncHash) == note )
+    m_syncHashIndex.remove(indexed.syncHash);
+  m_notebookIndex[indexed.notebook].remove(note);
+  if ( m_notebookIndex[indexed.notebook].isEmpty() )
+    m_notebookIndex.remove(indexed.notebook);
+  for ( Id tag : indexed.tags ) {
+    m_tagIndex[tag].remove(note);
+    if ( m_tagIndex[tag].isEmpty() )
+      m_tagIndex.remove(tag);
+  }
+  m_favoritedNotes.remove(note);
+  m_trashedNotes.remove(note);
+}
+
+void NoteDatabase::reindexNote(Note *note)
+{
+  IndexedNote &indexed = m_indexedNotes[note];
+  if ( m_syncHashIndex.value(indexed.syncHash) == note )
+    m_syncHashIndex.remove(indexed.syncHash);
+  indexed.syncHash = note->syncHash();
+  m_syncHashIndex.insert(indexed.syncHash, note);
+}
+
+void NoteDatabase::reindexNoteNotebook(Note *note)
+{
+  IndexedNote &indexed = m_indexedNotes[note];
+  m_notebookIndex[indexed.notebook].remove(note);
+  if ( m_notebookIndex[indexed.notebook].isEmpty() )
+    m_notebookIndex.remove(indexed.notebook);
+  indexed.notebook = m_store.notebook(m_store.row(note));
+  m_notebookIndex[indexed.notebook].insert(note);
+}
+
+void NoteDatabase::reindexNoteTags(Note *note)
+{
+  IndexedNote &indexed = m_indexedNotes[note];
+  for ( Id tag : indexed.tags ) {
+    m_tagIndex[tag].remove(note);
+    if ( m_tagIndex[tag].isEmpty() )
+      m_tagIndex.remove(tag);
+  }
+  indexed.tags = m_store.tags(m_store.row(note));
+  for ( Id tag : indexed.tags )
+    m_tagIndex[tag].insert(note);
+}
+
+QVector<SyncHashInterner::Id> NoteDatabase::internAll(const QVector<QUuid> &syncHashes)
+{
+  QVector<Id> ids;
+  ids.reserve(syncHashes.size());
+  for ( QUuid syncHash : syncHashes )
+    ids.append( syncHashInterner()->intern(syncHash) );
+  return ids;
+}
+
+QSet<SyncHashInterner::Id> NoteDatabase::knownIds(const QVector<QUuid> &syncHashes)
+{
+  QSet<Id> ids;
+  for ( QUuid syncHash : syncHashes ) {
+    Id id = syncHashInterner()->id(syncHash);
+    if ( id != 0 || syncHash.isNull() )
+      ids.insert(id);
+  }
+  return ids;
 }
 
 void NoteDatabase::slot_noteChanged(Note* note) {
-  m_sqlManager->updateNoteToDB(note);
+  // The note has already written its fields to its row.
+  NoteStore::Row row = storeRow(note);
+  if ( row != NOTE_STORE_NO_ROW ) {
+    if ( m_changedRows.isEmpty() )
+      QMetaObject::invokeMethod(this, "emitRowsChanged", Qt::QueuedConnection);
+    if ( m_changedRows.isEmpty() || m_changedRows.last() != row )
+      m_changedRows.append(row);
+  }
+
+  m_saveQueue->enqueue(note);
   emit noteChanged(note);
 }
 
+void NoteDatabase::emitRowsChanged()
+{
+  QVector<NoteStore::Row> rows = m_changedRows;
+  m_changedRows.clear();
+  std::sort(rows.begin(), rows.end());
+  rows.erase( std::unique(rows.begin(), rows.end()), rows.end() );
+  emit rowsChanged(rows);
+}
+
+const NoteStore &NoteDatabase::store() const
+{
+  return m_store;
+}
+
+NoteStore::Row NoteDatabase::storeRow(Note *note) const
+{
+  return m_store.row(note);
+}
+
 void NoteDatabase::handleNoteFavoritedChanged(Note* note) {
+  if ( note->favorited() )
+    m_favoritedNotes.insert(note);
+  else
+    m_favoritedNotes.remove(note);
   emit noteFavoritedChanged(note);
 }
+
+void NoteDatabase::handleNoteTrashedOrRestored(Note *note, bool trashed) {
+  if ( trashed )
+    m_trashedNotes.insert(note);
+  else
+    m_trashedNotes.remove(note);
+  emit noteTrashedOrRestored(note, trashed);
+}
+
+NoteSaveQueue *NoteDatabase::saveQueue() const
+{
+  return m_saveQueue;
+}
+
+void NoteDatabase::flushChanges()
+{
+  m_saveQueue->flush();
+  m_sqlManager->barrier();
+}
+
+bool NoteDatabase::hasFullTextSearch() const
+{
+  return m_sqlManager->hasFullTextSearch();
+}
+
+void NoteDatabase::postBodySearch(QString searchQuery)
+{
+  startBodySearch(searchQuery, nullptr);
+}
+
+void NoteDatabase::postBodySearch(QString searchQuery, const QVector<QUuid> &within)
+{
+  startBodySearch(searchQuery, &within);
+}
+
+void NoteDatabase::startBodySearch(QString searchQuery, const QVector<QUuid> *within)
+{
+  // Pending edits are posted first, so the search runs after them.
+  if ( m_saveQueue->pendingCount() > 0 )
+    m_saveQueue->flush();
+
+  // The trigram index narrows mid-word matches down to a few notes, whose
+  // text is then checked on the storage thread. Notes with the query in
+  // their title are left to the title search.
+  QByteArray key = HelperIO::searchKey(searchQuery);
+  QVector<QUuid> candidates;
+  if ( key.length() >= 3 ) {
+    QSet<QUuid> allowed;
+    if ( within != nullptr )
+      for ( QUuid syncHash : *within )
+        allowed.insert(syncHash);
+    for ( TrigramIndex::DocId id : trigramIndex().candidates(key) ) {
+      Note *note = m_trigramNotes.value(id);
+      if ( !note->searchKey().contains(key) &&
+           (within == nullptr || allowed.contains(note->syncHash())) )
+        candidates.append(note->syncHash());
+    }
+  }
+
+  bool fullText = hasFullTextSearch();
+  bool restricted = within != nullptr;
+  QVector<QUuid> notes = restricted ? *within : QVector<QUuid>();
+  int number = m_latestBodySearch->fetchAndAddOrdered(1) + 1;
+  QSharedPointer<QAtomicInt> latest = m_latestBodySearch;
+  QSharedPointer<PendingBodySearch> search(new PendingBodySearch);
+  search->searchQuery = searchQuery;
+
+  quint64 ticket = m_sqlManager->post([=](SQLManager *sql) {
+      if ( latest->loadAcquire() != number )
+        return true;
+      if ( fullText )
+        search->results.ranked = restricted ? sql->searchNotesWithin(searchQuery, notes)
+                                            : sql->searchNotes(searchQuery);
+      search->results.containing = sql->notesContaining(key, candidates);
+      search->done.storeRelease(1);
+      return true;
+    });
+
+  // Without a storage thread the search already ran.
+  if ( search->done.loadAcquire() )
+    emit bodySearchFinished(searchQuery, search->results);
+  else
+    m_bodySearches.insert(ticket, search);
+}
+
+void NoteDatabase::bodySearchCommitted(quint64 ticket)
+{
+  if ( m_bodySearches.isEmpty() )
+    return;
+  QSharedPointer<PendingBodySearch> search = m_bodySearches.take(ticket);
+  if ( search && search->done.loadAcquire() )
+    emit bodySearchFinished(search->searchQuery, search->results);
+}
+
+QVector<Note*> NoteDatabase::findNotesContaining(QString searchQuery)
+{
+  QByteArray key = HelperIO::searchKey(searchQuery);
+  QVector<Note*> notes;
+  if ( key.isEmpty() )
+    return notes;
+
+  // Having all the trigrams doesn't mean they are next to each other, so
+  // every candidate still gets checked.
+  QVector<Note*> bodyCandidates;
+  for ( TrigramIndex::DocId id : trigramIndex().candidates(key) ) {
+    Note *note = m_trigramNotes.value(id);
+    if ( note->searchKey().contains(key) )
+      notes.append(note);
+    else
+      bodyCandidates.append(note);
+  }
+
+  QHash<Note*, QString> texts = noteTexts(bodyCandidates);
+  for ( Note *note : bodyCandidates )
+    if ( HelperIO::searchKey(texts.value(note)).contains(key) )
+      notes.append(note);
+  return notes;
+}
+
+const TrigramIndex &NoteDatabase::trigramIndex()
+{
+  if ( !m_trigramIndexBuilt )
+    buildTrigramIndex();
+  else
+    reindexDirtyTrigrams();
+  // Removed notes leave their ids behind in the posting lists. Drop a few
+  // lists' worth of them per lookup rather than rebuilding everything.
+  m_trigramIndex.compact(TRIGRAM_COMPACT_STEP);
+  return m_trigramIndex;
+}
+
+void NoteDatabase::buildTrigramIndex()
+{
+  m_trigramIndex.clear();
+  m_trigramDocs.clear();
+  m_trigramNotes.clear();
+  m_dirtyTrigramNotes.clear();
+
+  // Read the text of unloaded notes straight from SQL without keeping it.
+  flushChanges();
+  m_sqlManager->forEachNoteText([this](QUuid syncHash, const QString &text) {
+    Note *note = findNoteWithSyncHash(syncHash);
+    if ( note != nullptr && !m_trigramDocs.contains(note) )
+      indexNoteTrigrams(note, note->textLoaded() ? note->text() : text);
+  });
+  // Notes that haven't reached SQL yet
+  for ( Note *note : m_list )
+    if ( !m_trigramDocs.contains(note) )
+      indexNoteTrigrams(note, note->textLoaded() ? note->text() : QString());
+
+  m_trigramIndexBuilt = true;
+}
+
+void NoteDatabase::reindexDirtyTrigrams()
+{
+  if ( m_dirtyTrigramNotes.isEmpty() )
+    return;
+  QVector<Note*> dirty = m_dirtyTrigramNotes.toList().toVector();
+  m_dirtyTrigramNotes.clear();
+
+  QHash<Note*, QString> texts = noteTexts(dirty);
+  for ( Note *note : dirty )
+    indexNoteTrigrams(note, texts.value(note));
+}
+
+void NoteDatabase::indexNoteTrigrams(Note *note, const QString &text)
+{
+  unindexNoteTrigrams(note);
+  TrigramIndex::DocId id = m_trigramIndex.add( note->searchKey() + '\n' + HelperIO::searchKey(text) );
+  m_trigramDocs.insert(note, id);
+  m_trigramNotes.insert(id, note);
+}
+
+void NoteDatabase::unindexNoteTrigrams(Note *note)
+{
+  m_dirtyTrigramNotes.remove(note);
+  auto it = m_trigramDocs.find(note);
+  if ( it == m_trigramDocs.end() )
+    return;
+  m_trigramIndex.remove(it.value());
+  m_trigramNotes.remove(it.value());
+  m_trigramDocs.erase(it);
+}
+
+void NoteDatabase::markNoteTrigramsDirty(Note *note)
+{
+  // Before the index is built there is nothing to bring up to date.
+  if ( m_trigramIndexBuilt )
+    m_dirtyTrigramNotes.insert(note);
+}
+
+QHash<Note*, QString> NoteDatabase::noteTexts(const QVector<Note*> &notes)
+{
+  QHash<Note*, QString> texts;
+  QVector<QUuid> unloaded;
+  for ( Note *note : notes ) {
+    if ( note->textLoaded() )
+      texts.insert(note, note->text());
+    else
+      unloaded.append(note->syncHash());
+  }
+  if ( unloaded.isEmpty() )
+    return texts;
+
+  // Make sure pending writes of these notes don't get read back stale.
+  m_sqlManager->barrier();
+  QHash<QUuid, QString> sqlTexts = m_sqlManager->noteTexts(unloaded);
+  for ( Note *note : notes )
+    if ( !note->textLoaded() )
+      texts.insert(note, sqlTexts.value(note->syncHash()));
+  return texts;
+}
+
+qint64 NoteDatabase::textMemoryBudget() const
+{
+  return m_textMemoryBudget;
+}
+
+void NoteDatabase::setTextMemoryBudget(qint64 bytes)
+{
+  m_textMemoryBudget = bytes;
+  trimNoteTexts();
+}
+
+qint64 NoteDatabase::textMemoryUsage() const
+{
+  return m_textMemoryUsage;
+}
+
+void NoteDatabase::loadNoteText(Note *note)
+{
+  // Make sure a pending write of this note's text does not get read back stale.
+  m_sqlManager->barrier();
+  note->setText_primitive( m_sqlManager->noteText(note->syncHash()) );
+  touchNoteText(note);
+}
+
+void NoteDatabase::touchNoteText(Note *note)
+{
+  qint64 cost = note->text().size() * static_cast<qint64>(sizeof(QChar));
+  m_textMemoryUsage += cost - m_textCost.value(note, 0);
+  m_textCost[note] = cost;
+
+  auto position = m_textLruPositions.find(note);
+  if ( position != m_textLruPositions.end() )
+    m_textLru.splice(m_textLru.begin(), m_textLru, position.value());
+  else
+    m_textLruPositions.insert(note, m_textLru.insert(m_textLru.begin(), note));
+  trimNoteTexts();
+}
+
+void NoteDatabase::forgetNoteText(Note *note)
+{
+  m_textMemoryUsage -= m_textCost.take(note);
+  auto position = m_textLruPositions.find(note);
+  if ( position != m_textLruPositions.end() ) {
+    m_textLru.erase(position.value());
+    m_textLruPositions.erase(position);
+  }
+}
+
+void NoteDatabase::trimNoteTexts()
+{
+  // The most recently used note always keeps its text, even if it is
+  // bigger than the budget on its own.
+  while ( m_textMemoryUsage > m_textMemoryBudget && m_textLru.size() > 1 ) {
+    Note *note = m_textLru.back();
+    // Unsaved text must reach SQL before it is dropped from memory.
+    m_saveQueue->flush(note);
+    forgetNoteText(note);
+    note->unloadText();
+  }
+}
@@ -7,28 +7,53 @@
 #ifndef NOTELIST_H
 #define NOTELIST_H
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <list>
 #include "../note.h"
 #include "../../sql/sqlmanager.h"
+#include "../../sql/notesavequeue.h"
+#include "trigramindex.h"
+#include "notestore.h"
 
 #define NULL_INT -1
 
+// Maximum amount of note text kept in memory before the least recently
+// used notes get their text unloaded. Can be overriden in the config.
+#define NOTE_TEXT_DEFAULT_MEMORY_BUDGET (32*1024*1024)
+
+#define TRIGRAM_COMPACT_STEP 256 // Posting lists compacted per trigram lookup
+
+// Results of NoteDatabase::postBodySearch()
+struct NoteBodySearch {
+  QVector<NoteSearchResult> ranked; // Full-text matches, best first
+  QVector<QUuid> containing;        // Notes whose text has the query mid-word
+};
+
 class NoteDatabase : public QObject
 {
   Q_OBJECT
 public:
   NoteDatabase(SQLManager *sqlManager);
+  ~NoteDatabase();
 
   // Lists out the notes in the in-memory database
   QList<Note*> list() const;
   int          size() const;
 
   Note *addNote(Note *note, bool addToSQL=true);
+  // Adds many notes at once and announces them with a single notesAdded.
+  QVector<Note*> addNotes(QVector<Note*> notes, bool addToSQL=true);
   Note *addDefaultNote(); // Takes note, sets certain fields to default values.
   //p Note *addNote(Note note);
 
   void removeNote(int index);
   void removeNote(Note *note);
   void removeNotes(QVector<Note*> notes);
+  // Takes notes out of the trash and saves them in a single transaction.
+  void restoreNotes(QVector<Note*> notes);
   void clearNotes();
 
   void loadSQL();
@@ -38,27 +63,159 @@ public:
 
   void removeTagFromNotes(QUuid tagSyncHash);
 
-  QVector<Note*> findNotesWithNotebookIDs(QVector<QUuid> notebookIDs);
+  QVector<Note*> findNotesWithNotebookIDs(QVector<QUuid> notebookIDs) const;
+  int countNotesWithNotebookIDs(QVector<QUuid> notebookIDs) const;
 
   bool noteWithSyncHashExists(QUuid syncHash) const;
+  Note *findNoteWithSyncHash(QUuid syncHash) const;
+
+  // Membership sets, kept up to date as notes change.
+  QSet<Note*> notesWithTag(QUuid tagSyncHash) const;
+  QSet<Note*> favoritedNotes() const;
+  QSet<Note*> trashedNotes() const;
+
+  // Titles, dates, notebook, tags and flags of every note, column by
+  // column. The note list filters and sorts on these instead of on the notes.
+  const NoteStore &store() const;
+  // NOTE_STORE_NO_ROW if the note isn't in the database
+  NoteStore::Row storeRow(Note *note) const;
+
+  // Note text is loaded on demand and kept in a least-recently-used list
+  // that is trimmed whenever it grows beyond the memory budget.
+  qint64 textMemoryBudget() const;
+  void   setTextMemoryBudget(qint64 bytes);
+  qint64 textMemoryUsage() const;
+
+  // Changed notes are not written to SQL right away. They wait in the save
+  // queue until it is flushed.
+  NoteSaveQueue *saveQueue() const;
+  void flushChanges();
+
+  bool hasFullTextSearch() const;
+
+  // Searches note bodies while the user types, without blocking the GUI
+  // thread. The search is posted behind the pending writes and runs on the
+  // storage thread, so it sees every edit made so far. bodySearchFinished()
+  // delivers the results. Searches overtaken by a newer one skip their work.
+  void postBodySearch(QString searchQuery);
+  // Same, but only among the given notes.
+  void postBodySearch(QString searchQuery, const QVector<QUuid> &within);
+
+  // Notes whose title or text contain searchQuery anywhere, also in the
+  // middle of words. Case and diacritics are ignored. (see HelperIO::searchKey)
+  // The trigram index behind it is built on first use, and brought up to
+  // date with edited notes on every lookup.
+  QVector<Note*> findNotesContaining(QString searchQuery);
+  const TrigramIndex &trigramIndex();
 
 signals:
   // Important: 'Trashed' means the *Note is set as trashed=true.
   //            'Deleted' means the *Note was deleted and removed from database. (Permanent)
   void noteAdded(Note *note);
+  void notesAdded(QVector<Note*> notes);
   void noteChanged(Note *note);
+  // Rows of the notes changed since the last time, emitted once per
+  // event loop turn no matter how many changes there were.
+  void rowsChanged(QVector<NoteStore::Row> rows);
   void noteTrashedOrRestored(Note *note, bool trashed);
+  void noteAboutToBeDeleted(Note *note);
+  // removeNotes() announces all of its notes at once before the
+  // noteAboutToBeDeleted of each one.
+  void notesAboutToBeDeleted(QVector<Note*> notes);
   void noteDeleted(QUuid noteSyncHash);
   void noteFavoritedChanged(Note *note);
+  void bodySearchFinished(QString searchQuery, NoteBodySearch results);
 
 private slots:
   void slot_noteChanged(Note *note);
   void handleNoteFavoritedChanged(Note *note);
+  void handleNoteTrashedOrRestored(Note *note, bool trashed);
+  void loadNoteText(Note *note);
+  void touchNoteText(Note *note);
+  void reindexNote(Note *note);
+  void reindexNoteNotebook(Note *note);
+  void reindexNoteTags(Note *note);
+  void markNoteTrigramsDirty(Note *note);
+  void emitRowsChanged();
+  void bodySearchCommitted(quint64 ticket);
 
 private:
   SQLManager *m_sqlManager;
+  NoteSaveQueue *m_saveQueue;
   QList<Note*> m_list;
 
+  // What each note is currently filed under in the indexes below, so its
+  // old entries can be found when it changes.
+  // Notebooks and tags are filed under their interned ids.
+  typedef SyncHashInterner::Id Id;
+  struct IndexedNote {
+    QUuid syncHash;
+    Id notebook;
+    QVector<Id> tags;
+  };
+  QHash<Note*, IndexedNote> m_indexedNotes;
+
+  QHash<QUuid, Note*> m_syncHashIndex;
+  QHash<Id, QSet<Note*>> m_notebookIndex;
+  QHash<Id, QSet<Note*>> m_tagIndex;
+
+  static QVector<Id> internAll(const QVector<QUuid> &syncHashes);
+  // Ids of the given sync hashes that were interned. The others can't be
+  // in any index.
+  static QSet<Id> knownIds(const QVector<QUuid> &syncHashes);
+  QSet<Note*> m_favoritedNotes;
+  QSet<Note*> m_trashedNotes;
+
+  void attachNote(Note *note, bool addToSQL);
+  void indexNote(Note *note);
+  void unindexNote(Note *note);
+
+  NoteStore m_store;
+  QVector<NoteStore::Row> m_changedRows;
+
+  // Trigrams of every note's folded title and text.
+  bool m_trigramIndexBuilt=false;
+  TrigramIndex m_trigramIndex;
+  QHash<Note*, TrigramIndex::DocId> m_trigramDocs;
+  QHash<TrigramIndex::DocId, Note*> m_trigramNotes;
+  // Notes edited since the last lookup. They are re-indexed in one go
+  // right before the next one, instead of on every keystroke.
+  QSet<Note*> m_dirtyTrigramNotes;
+
+  void buildTrigramIndex();
+  void reindexDirtyTrigrams();
+  void indexNoteTrigrams(Note *note, const QString &text);
+  void unindexNoteTrigrams(Note *note);
+  // Text of every note, read in one query for the unloaded ones.
+  QHash<Note*, QString> noteTexts(const QVector<Note*> &notes);
+
+  // Body searches posted to the storage thread, by ticket. Filled in over
+  // there, and only read here once done is set.
+  struct PendingBodySearch {
+    QString searchQuery;
+    NoteBodySearch results;
+    QAtomicInt done;
+  };
+  QHash<quint64, QSharedPointer<PendingBodySearch>> m_bodySearches;
+  // Number of the latest body search, shared with the ones still queued.
+  QSharedPointer<QAtomicInt> m_latestBodySearch;
+
+  void startBodySearch(QString searchQuery, const QVector<QUuid> *within);
+
+  // Notes with loaded text, most recently used first. m_textLruPositions
+  // lets a note be moved to the front without searching the list.
+  std::list<Note*> m_textLru;
+  QHash<Note*, std::list<Note*>::iterator> m_textLruPositions;
+  QHash<Note*, qint64> m_textCost;
+  qint64 m_textMemoryUsage=0;
+  qint64 m_textMemoryBudget=NOTE_TEXT_DEFAULT_MEMORY_BUDGET;
+
+  void releaseNote(Note *note);
+  void forgetNoteText(Note *note);
+  void trimNoteTexts();
+
 };
 
+Q_DECLARE_METATYPE(NoteBodySearch)
+
 #endif // NOTELIST_H
@@ -0,0 +1,214 @@
+#include "notestore.h"
+#include "../note.h"
+
+NoteStore::NoteStore()
+{
+}
+
+NoteStore::~NoteStore()
+{
+  clear();
+}
+
+NoteStore::Row NoteStore::insert(Note *note, QVector<Id> tags)
+{
+  Row row;
+  if ( !m_freeRows.isEmpty() ) {
+    row = m_freeRows.takeLast();
+  }
+  else {
+    row = static_cast<Row>(m_notes.size());
+    m_notes.append(nullptr);
+    m_titles.append(QString());
+    m_dateCreated.append(0);
+    m_dateModified.append(0);
+    m_notebooks.append(0);
+    m_flags.append(0);
+    m_tags.append(QVector<Id>());
+  }
+
+  const Note::Fields *fields = note->m_fields;
+  m_notes[row]        = note;
+  m_titles[row]       = fields->title;
+  m_dateCreated[row]  = fields->dateCreated.toMSecsSinceEpoch();
+  m_dateModified[row] = fields->dateModified.toMSecsSinceEpoch();
+  m_notebooks[row]    = syncHashInterner()->intern(fields->notebook);
+  m_tags[row]         = tags;
+
+  quint8 flags = 0;
+  if ( fields->favorited ) flags |= Favorited;
+  if ( fields->encrypted ) flags |= Encrypted;
+  if ( fields->trashed )   flags |= Trashed;
+  m_flags[row] = flags;
+
+  delete note->m_fields;
+  note->m_fields = nullptr;
+  note->m_store = this;
+  note->m_storeRow = row;
+  return row;
+}
+
+void NoteStore::remove(Row row)
+{
+  if ( !contains(row) )
+    return;
+  detach(row);
+  m_notes[row] = nullptr;
+  m_titles[row] = QString();
+  m_tags[row] = QVector<Id>();
+  m_freeRows.append(row);
+}
+
+void NoteStore::clear()
+{
+  for (Row row = 0; row < static_cast<Row>(m_notes.size()); row++)
+    if ( m_notes.at(row) != nullptr )
+      detach(row);
+  m_notes.clear();
+  m_titles.clear();
+  m_dateCreated.clear();
+  m_dateModified.clear();
+  m_notebooks.clear();
+  m_flags.clear();
+  m_tags.clear();
+  m_freeRows.clear();
+}
+
+void NoteStore::detach(Row row)
+{
+  Note *note = m_notes.at(row);
+  Note::Fields *fields = new Note::Fields;
+  fields->title        = m_titles.at(row);
+  fields->dateCreated  = QDateTime::fromMSecsSinceEpoch(m_dateCreated.at(row));
+  fields->dateModified = QDateTime::fromMSecsSinceEpoch(m_dateModified.at(row));
+  fields->notebook     = syncHashInterner()->syncHash(m_notebooks.at(row));
+  for ( Id tag : m_tags.at(row) )
+    fields->tags.append( syncHashInterner()->syncHash(tag) );
+  fields->favorited    = favorited(row);
+  fields->encrypted    = encrypted(row);
+  fields->trashed      = trashed(row);
+
+  note->m_fields = fields;
+  note->m_store = nullptr;
+  note->m_storeRow = NOTE_STORE_NO_ROW;
+}
+
+bool NoteStore::contains(Row row) const
+{
+  return row < static_cast<Row>(m_notes.size()) && m_notes.at(row) != nullptr;
+}
+
+int NoteStore::size() const
+{
+  return m_notes.size() - m_freeRows.size();
+}
+
+int NoteStore::capacity() const
+{
+  return m_notes.size();
+}
+
+Note *NoteStore::note(Row row) const
+{
+  return row < static_cast<Row>(m_notes.size()) ? m_notes.at(row) : nullptr;
+}
+
+NoteStore::Row NoteStore::row(const Note *note) const
+{
+  return note->m_store == this ? note->m_storeRow : NOTE_STORE_NO_ROW;
+}
+
+QString NoteStore::title(Row row) const
+{
+  return m_titles.at(row);
+}
+
+qint64 NoteStore::dateCreated(Row row) const
+{
+  return m_dateCreated.at(row);
+}
+
+qint64 NoteStore::dateModified(Row row) const
+{
+  return m_dateModified.at(row);
+}
+
+NoteStore::Id NoteStore::notebook(Row row) const
+{
+  return m_notebooks.at(row);
+}
+
+bool NoteStore::favorited(Row row) const
+{
+  return m_flags.at(row) & Favorited;
+}
+
+bool NoteStore::encrypted(Row row) const
+{
+  return m_flags.at(row) & Encrypted;
+}
+
+bool NoteStore::trashed(Row row) const
+{
+  return m_flags.at(row) & Trashed;
+}
+
+bool NoteStore::hasTag(Row row, Id tag) const
+{
+  return m_tags.at(row).contains(tag);
+}
+
+QVector<NoteStore::Id> NoteStore::tags(Row row) const
+{
+  return m_tags.at(row);
+}
+
+void NoteStore::setTitle(Row row, const QString &title)
+{
+  m_titles[row] = title;
+}
+
+void NoteStore::setDateCreated(Row row, qint64 msecs)
+{
+  m_dateCreated[row] = msecs;
+}
+
+void NoteStore::setDateModified(Row row, qint64 msecs)
+{
+  m_dateModified[row] = msecs;
+}
+
+void NoteStore::setNotebook(Row row, Id notebook)
+{
+  m_notebooks[row] = notebook;
+}
+
+void NoteStore::setTags(Row row, QVector<Id> tags)
+{
+  m_tags[row] = tags;
+}
+
+void NoteStore::setFlag(Row row, Flags flag, bool set)
+{
+  if ( set )
+    m_flags[row] |= flag;
+  else
+    m_flags[row] &= ~flag;
+}
+
+qint64 NoteStore::memoryUsage() const
+{
+  qint64 bytes = m_notes.capacity() * sizeof(Note*)
+               + m_titles.capacity() * sizeof(QString)
+               + m_dateCreated.capacity() * sizeof(qint64)
+               + m_dateModified.capacity() * sizeof(qint64)
+               + m_notebooks.capacity() * sizeof(Id)
+               + m_flags.capacity() * sizeof(quint8)
+               + m_tags.capacity() * sizeof(QVector<Id>)
+               + m_freeRows.capacity() * sizeof(Row);
+  for (const QString &title : m_titles)
+    bytes += title.capacity() * sizeof(QChar);
+  for (const QVector<Id> &tags : m_tags)
+    bytes += tags.capacity() * sizeof(Id);
+  return bytes;
+}
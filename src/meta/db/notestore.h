@@ -0,0 +1,90 @@
+/*
+ * NoteStore
+ * The fields of every note that the note list filters and sorts on, kept
+ * column by column in flat arrays instead of inside each Note. A note is
+ * referred to by its row, which stays the same for as long as the note is
+ * in the store. Rows of removed notes are handed out again.
+ *
+ * The store is the only copy of these fields. A note in the store reads
+ * and writes them through its row, and only holds them itself while it
+ * is in no store.
+ *
+ * Notebooks and tags are stored by their interned ids, so comparing them
+ * does not touch the 128-bit uuids. (see SyncHashInterner)
+ */
+
+#ifndef NOTESTORE_H
+#define NOTESTORE_H
+#include <QHash>
+#include <QUuid>
+#include <QVector>
+#include <climits>
+#include "synchashinterner.h"
+
+// Row of a note that is not in the store
+#define NOTE_STORE_NO_ROW UINT_MAX
+
+class Note;
+
+class NoteStore
+{
+public:
+  typedef quint32 Row;
+  typedef SyncHashInterner::Id Id;
+
+  enum Flags : quint8 {
+    Favorited = 0x1,
+    Encrypted = 0x2,
+    Trashed   = 0x4
+  };
+
+  NoteStore();
+  ~NoteStore();
+
+  // Moves the note's fields into a new row. tags are the note's interned
+  // tag ids.
+  Row  insert(Note *note, QVector<Id> tags);
+  // Hands the row's fields back to its note.
+  void remove(Row row);
+  void clear();
+
+  bool    contains(Row row) const;
+  int     size() const;     // Amount of notes in the store
+  int     capacity() const; // Amount of rows, including the ones free for reuse
+  Note   *note(Row row) const;
+  Row     row(const Note *note) const; // NOTE_STORE_NO_ROW if it isn't in the store
+  QString title(Row row) const;
+  qint64  dateCreated(Row row) const;  // Milliseconds since epoch
+  qint64  dateModified(Row row) const; // Milliseconds since epoch
+  Id      notebook(Row row) const;
+  bool    favorited(Row row) const;
+  bool    encrypted(Row row) const;
+  bool    trashed(Row row) const;
+  bool    hasTag(Row row, Id tag) const;
+  QVector<Id> tags(Row row) const;
+
+  // Used by Note. These do not emit anything, the note does.
+  void setTitle(Row row, const QString &title);
+  void setDateCreated(Row row, qint64 msecs);
+  void setDateModified(Row row, qint64 msecs);
+  void setNotebook(Row row, Id notebook);
+  void setTags(Row row, QVector<Id> tags);
+  void setFlag(Row row, Flags flag, bool set);
+
+  qint64 memoryUsage() const; // Bytes used by the columns
+
+private:
+  QVector<Note*>  m_notes;
+  QVector<QString> m_titles;
+  QVector<qint64> m_dateCreated;
+  QVector<qint64> m_dateModified;
+  QVector<Id>     m_notebooks;
+  QVector<quint8> m_flags;
+  QVector<QVector<Id>> m_tags; // In the note's order, there are only a few
+  QVector<Row>    m_freeRows;
+
+  // Gives the note back its own copy of the row's fields.
+  void detach(Row row);
+};
+
+#endif // NOTESTORE_H
@@ -0,0 +1,42 @@
+#include "synchashinterner.h"
+
+SyncHashInterner::SyncHashInterner()
+{
+  m_syncHashes.append(QUuid());
+}
+
+SyncHashInterner::Id SyncHashInterner::intern(QUuid syncHash)
+{
+  if ( syncHash.isNull() )
+    return 0;
+  auto it = m_ids.constFind(syncHash);
+  if ( it != m_ids.constEnd() )
+    return it.value();
+  Id id = static_cast<Id>(m_syncHashes.size());
+  m_syncHashes.append(syncHash);
+  m_ids.insert(syncHash, id);
+  return id;
+}
+
+SyncHashInterner::Id SyncHashInterner::id(QUuid syncHash) const
+{
+  if ( syncHash.isNull() )
+    return 0;
+  return m_ids.value(syncHash, 0);
+}
+
+QUuid SyncHashInterner::syncHash(Id id) const
+{
+  return id < static_cast<Id>(m_syncHashes.size()) ? m_syncHashes.at(id) : QUuid();
+}
+
+int SyncHashInterner::size() const
+{
+  return m_syncHashes.size();
+}
+
+SyncHashInterner *syncHashInterner()
+{
+  static SyncHashInterner interner;
+  return &interner;
+}
@@ -0,0 +1,39 @@
+/*
+ * SyncHashInterner
+ * Hands every sync hash a small integer id, the first time it is seen.
+ * Ids are dense and never reused, so the in-memory databases can keep
+ * per-notebook or per-tag data in plain vectors indexed by id and compare
+ * ids instead of 128-bit uuids. Uuids (and their text) are only needed
+ * again when talking to SQL.
+ *
+ * Id 0 always stands for the null uuid. The interner is only used from
+ * the GUI thread.
+ */
+
+#ifndef SYNCHASHINTERNER_H
+#define SYNCHASHINTERNER_H
+#include <QHash>
+#include <QUuid>
+#include <QVector>
+
+class SyncHashInterner
+{
+public:
+  typedef quint32 Id;
+
+  SyncHashInterner();
+
+  Id    intern(QUuid syncHash);
+  Id    id(QUuid syncHash) const; // 0 if syncHash was never interned
+  QUuid syncHash(Id id) const;
+  int   size() const; // Amount of ids handed out, including 0
+
+private:
+  QHash<QUuid, Id> m_ids;
+  QVector<QUuid>   m_syncHashes;
+};
+
+// The interner shared by every database.
+SyncHashInterner *syncHashInterner();
+
+#endif // SYNCHASHINTERNER_H
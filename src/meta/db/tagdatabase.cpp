@@ -21,19 +21,22 @@ int TagDatabase::size() const
   return m_list.size();
 }
 
-void TagDatabase::addTag(Tag *tag)
+bool TagDatabase::addTag(Tag *tag)
 {
   // Don't allow duplicate tags in our tag database
-  for ( Tag *t : m_list ) {
-    if ( t->title().toLower() == tag->title().toLower() )
-      return;
-  }
+  if ( findTagWithName(tag->title()) )
+    return false;
 
   m_list.append(tag);
+  indexTag(tag);
+  indexTitle(tag);
   connect(tag, &Tag::changed,
           this, &TagDatabase::changed_slot);
+  connect(tag, &Tag::syncHashChanged,
+          this, &TagDatabase::syncHashChanged_slot);
 
   emit added(tag);
+  return true;
 }
 
 Tag *TagDatabase::addTag(QString title)
@@ -48,7 +51,7 @@ Tag *TagDatabase::addTag(QString title)
 
   Tag *tag = new Tag();
   tag->setTitle(title);
-  m_sqlManager->addTag(tag);
+  m_sqlManager->postAddTag(tag);
   addTag(tag);
 
   return tag;
@@ -59,7 +62,9 @@ void TagDatabase::removeTag(int index)
   Tag *tag = m_list[index];
   QUuid sync_hash = tag->syncHash();
 
-  m_sqlManager->deleteTag(tag);
+  m_sqlManager->postDeleteTag(sync_hash);
+  unindexTag(tag);
+  unindexTitle(tag);
   delete tag;
 
   m_list.removeAt(index);
@@ -80,35 +85,90 @@ void TagDatabase::clearTags()
   for (int i = m_list.size()-1; i >= 0; i--) {
     removeTag(i);
   }
+  Tag::releasePool();
 }
 
 Tag *TagDatabase::findTagWithSyncHash(QUuid syncHash)
 {
-  for (Tag *tag : m_list) {
-    if (tag->syncHash() == syncHash)
-      return tag;
-  }
-  return nullptr;
+  SyncHashInterner::Id id = syncHashInterner()->id(syncHash);
+  if ( id == 0 && !syncHash.isNull() )
+    return nullptr;
+  return findTagWithId(id);
+}
+
+Tag *TagDatabase::findTagWithId(SyncHashInterner::Id id) const
+{
+  return id < static_cast<SyncHashInterner::Id>(m_tagsById.size()) ? m_tagsById.at(id) : nullptr;
 }
 
 Tag *TagDatabase::findTagWithName(QString name)
 {
-  for (Tag *tag : m_list)
-    if ( QString::compare(tag->title(), name, Qt::CaseInsensitive) == 0 )
-      return tag;
-  return nullptr;
+  return m_tagsByTitle.value(name.toCaseFolded(), nullptr);
 }
 
 void TagDatabase::loadSQL()
 {
   QVector<Tag*> tags = m_sqlManager->tags();
+  m_list.reserve(m_list.size() + tags.size());
+  m_tagIds.reserve(m_tagIds.size() + tags.size());
+  m_tagsByTitle.reserve(m_tagsByTitle.size() + tags.size());
+  m_titleKeys.reserve(m_titleKeys.size() + tags.size());
   for (Tag *tag : tags)
-    addTag(tag);
+    if ( !addTag(tag) )
+      delete tag;
 }
 
 void TagDatabase::changed_slot(Tag *tag)
 {
   qDebug() << tag->title() << "Changed!" << tag->row();
-  m_sqlManager->updateTagToDB(tag);
+  if ( m_titleKeys.value(tag) != tag->title().toCaseFolded() ) {
+    unindexTitle(tag);
+    indexTitle(tag);
+  }
+  m_sqlManager->postUpdateTag(tag);
   emit changed(tag);
 }
+
+void TagDatabase::syncHashChanged_slot(Tag *tag)
+{
+  unindexTag(tag);
+  indexTag(tag);
+}
+
+void TagDatabase::indexTag(Tag *tag)
+{
+  SyncHashInterner::Id id = syncHashInterner()->intern(tag->syncHash());
+  if ( id >= static_cast<SyncHashInterner::Id>(m_tagsById.size()) )
+    m_tagsById.resize(syncHashInterner()->size());
+  m_tagsById[id] = tag;
+  m_tagIds.insert(tag, id);
+}
+
+void TagDatabase::unindexTag(Tag *tag)
+{
+  auto it = m_tagIds.find(tag);
+  if ( it == m_tagIds.end() )
+    return;
+  if ( m_tagsById.at(it.value()) == tag )
+    m_tagsById[it.value()] = nullptr;
+  m_tagIds.erase(it);
+}
+
+void TagDatabase::indexTitle(Tag *tag)
+{
+  QString key = tag->title().toCaseFolded();
+  // A tag renamed to the title of another one doesn't take its place.
+  if ( !m_tagsByTitle.contains(key) )
+    m_tagsByTitle.insert(key, tag);
+  m_titleKeys.insert(tag, key);
+}
+
+void TagDatabase::unindexTitle(Tag *tag)
+{
+  auto it = m_titleKeys.find(tag);
+  if ( it == m_titleKeys.end() )
+    return;
+  if ( m_tagsByTitle.value(it.value()) == tag )
+    m_tagsByTitle.remove(it.value());
+  m_titleKeys.erase(it);
+}
@@ -4,7 +4,9 @@
 #include <QVector>
 #include <QJsonDocument>
 #include <QUuid>
+#include <QHash>
 #include "../tag.h"
+#include "synchashinterner.h"
 #include "../../sql/sqlmanager.h"
 
 class TagDatabase : public QObject
@@ -15,7 +17,7 @@ public:
   QVector<Tag*> list() const;
   int           size() const;
 
-  void addTag(Tag *tag);
+  bool addTag(Tag *tag); // False for duplicates, which the caller still owns
   Tag *addTag(QString title);
 
   void removeTag(int index);
@@ -23,12 +25,14 @@ public:
   void clearTags();
 
   Tag *findTagWithSyncHash(QUuid syncHash);
+  Tag *findTagWithId(SyncHashInterner::Id id) const;
   Tag *findTagWithName(QString name);
 
   void loadSQL();
 
 private slots:
   void changed_slot(Tag *tag);
+  void syncHashChanged_slot(Tag *tag);
 
 signals:
   void added(Tag *tag);
@@ -38,6 +42,21 @@ signals:
 private:
   SQLManager *m_sqlManager;
   QVector<Tag*> m_list;
+
+  // Tags by their interned sync hash. m_tagIds remembers what each tag
+  // was filed under, so it can be moved when its sync hash changes.
+  QVector<Tag*> m_tagsById;
+  QHash<Tag*, SyncHashInterner::Id> m_tagIds;
+
+  // Tags by their case folded title, for duplicate checks and name
+  // lookups. m_titleKeys remembers the key each tag was filed under.
+  QHash<QString, Tag*> m_tagsByTitle;
+  QHash<Tag*, QString> m_titleKeys;
+
+  void indexTag(Tag *tag);
+  void unindexTag(Tag *tag);
+  void indexTitle(Tag *tag);
+  void unindexTitle(Tag *tag);
 };
 
 #endif // TAGDATABASE_H
@@ -0,0 +1,186 @@
+#include "trigramindex.h"
+#include <algorithm>
+
+static void appendVarint(QByteArray &bytes, quint32 value)
+{
+  while ( value >= 0x80 ) {
+    bytes.append( static_cast<char>((value & 0x7f) | 0x80) );
+    value >>= 7;
+  }
+  bytes.append( static_cast<char>(value) );
+}
+
+TrigramIndex::DocId TrigramIndex::add(const QByteArray &key)
+{
+  DocId id = static_cast<DocId>(m_live.size());
+  m_live.append(true);
+  m_liveCount++;
+
+  // Ids only grow, so every posting list stays sorted by appending.
+  for ( quint32 trigram : trigrams(key) ) {
+    Posting &posting = m_postings[trigram];
+    appendVarint(posting.deltas, posting.count == 0 ? id : id - posting.last);
+    posting.last = id;
+    posting.count++;
+  }
+  return id;
+}
+
+void TrigramIndex::remove(DocId id)
+{
+  if ( !isLive(id) )
+    return;
+  m_live[static_cast<int>(id)] = false;
+  m_liveCount--;
+  m_removedCount++;
+}
+
+void TrigramIndex::clear()
+{
+  m_postings.clear();
+  m_live.clear();
+  m_liveCount = 0;
+  m_removedCount = 0;
+  m_sweepTrigrams.clear();
+  m_sweepPosition = 0;
+  m_sweepRemovedCount = 0;
+}
+
+void TrigramIndex::compact(int maxPostings)
+{
+  if ( m_sweepPosition >= m_sweepTrigrams.size() ) {
+    if ( m_removedCount == 0 )
+      return;
+    m_sweepTrigrams = m_postings.keys().toVector();
+    m_sweepPosition = 0;
+    m_sweepRemovedCount = m_removedCount;
+  }
+
+  int end = qMin(m_sweepPosition + maxPostings, m_sweepTrigrams.size());
+  for ( ; m_sweepPosition < end; m_sweepPosition++ ) {
+    auto it = m_postings.find( m_sweepTrigrams.at(m_sweepPosition) );
+    if ( it == m_postings.end() )
+      continue;
+
+    Posting compacted;
+    for ( DocId id : decode(it.value()) ) {
+      if ( !isLive(id) )
+        continue;
+      appendVarint(compacted.deltas, compacted.count == 0 ? id : id - compacted.last);
+      compacted.last = id;
+      compacted.count++;
+    }
+    if ( compacted.count == 0 )
+      m_postings.erase(it);
+    else
+      it.value() = compacted;
+  }
+
+  if ( m_sweepPosition >= m_sweepTrigrams.size() ) {
+    m_removedCount -= m_sweepRemovedCount;
+    m_sweepTrigrams.clear();
+    m_sweepPosition = 0;
+    m_sweepRemovedCount = 0;
+  }
+}
+
+QVector<TrigramIndex::DocId> TrigramIndex::candidates(const QByteArray &key) const
+{
+  QVector<DocId> result;
+  QVector<quint32> keyTrigrams = trigrams(key);
+
+  if ( keyTrigrams.isEmpty() ) {
+    for ( int id = 0; id < m_live.size(); id++ )
+      if ( m_live.at(id) )
+        result.append( static_cast<DocId>(id) );
+    return result;
+  }
+
+  // Intersect starting from the shortest list, so the working set is as
+  // small as it can be from the start.
+  QVector<const Posting*> postings;
+  for ( quint32 trigram : keyTrigrams ) {
+    auto it = m_postings.constFind(trigram);
+    if ( it == m_postings.constEnd() )
+      return result;
+    postings.append( &it.value() );
+  }
+  std::sort(postings.begin(), postings.end(), [](const Posting *a, const Posting *b) {
+    return a->count < b->count;
+  });
+
+  result = decode(*postings.first());
+  for ( int i = 1; i < postings.size() && !result.isEmpty(); i++ ) {
+    QVector<DocId> other = decode(*postings.at(i));
+    QVector<DocId> intersection;
+    std::set_intersection(result.begin(), result.end(), other.begin(), other.end(),
+                          std::back_inserter(intersection));
+    result = intersection;
+  }
+
+  result.erase( std::remove_if(result.begin(), result.end(),
+                               [this](DocId id) { return !isLive(id); }),
+                result.end() );
+  return result;
+}
+
+bool TrigramIndex::isLive(DocId id) const
+{
+  return id < static_cast<DocId>(m_live.size()) && m_live.at(static_cast<int>(id));
+}
+
+int TrigramIndex::liveCount() const
+{
+  return m_liveCount;
+}
+
+int TrigramIndex::removedCount() const
+{
+  return m_removedCount;
+}
+
+int TrigramIndex::postingCount() const
+{
+  return m_postings.size();
+}
+
+qint64 TrigramIndex::memoryUsage() const
+{
+  qint64 bytes = 0;
+  for ( const Posting &posting : m_postings )
+    bytes += posting.deltas.size();
+  return bytes;
+}
+
+QVector<quint32> TrigramIndex::trigrams(const QByteArray &key)
+{
+  QVector<quint32> result;
+  for ( int i = 0; i + 3 <= key.size(); i++ ) {
+    const uchar *bytes = reinterpret_cast<const uchar*>(key.constData() + i);
+    result.append( (quint32(bytes[0]) << 16) | (quint32(bytes[1]) << 8) | quint32(bytes[2]) );
+  }
+  std::sort(result.begin(), result.end());
+  result.erase( std::unique(result.begin(), result.end()), result.end() );
+  return result;
+}
+
+QVector<TrigramIndex::DocId> TrigramIndex::decode(const Posting &posting)
+{
+  QVector<DocId> ids;
+  ids.reserve(posting.count);
+  DocId id = 0;
+  quint32 value = 0;
+  int shift = 0;
+  for ( char byte : posting.deltas ) {
+    value |= quint32(static_cast<uchar>(byte) & 0x7f) << shift;
+    if ( static_cast<uchar>(byte) & 0x80 ) {
+      shift += 7;
+      continue;
+    }
+    id = ids.isEmpty() ? value : id + value;
+    ids.append(id);
+    value = 0;
+    shift = 0;
+  }
+  return ids;
+}
@@ -0,0 +1,65 @@
+/*
+ * TrigramIndex
+ * Maps every run of three bytes in a document's key to the documents that
+ * contain it. A substring of three bytes or more can only occur in documents
+ * that contain all of its trigrams, so lookups narrow a search down to a
+ * few candidates that then have to be checked for real.
+ *
+ * Posting lists are kept sorted and stored as varint-encoded deltas between
+ * document ids. Documents are never edited in place. Re-indexing a
+ * document removes its old id and adds it under a new one. Removed ids
+ * are skipped by lookups and dropped from the posting lists a few lists
+ * at a time by compact(), so no single call has to rewrite the index.
+ */
+
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+class TrigramIndex
+{
+public:
+  typedef quint32 DocId;
+
+  DocId add(const QByteArray &key);
+  void  remove(DocId id);
+  void  clear();
+
+  // Live documents containing every trigram of key, in ascending order.
+  // Keys shorter than a trigram match every live document.
+  QVector<DocId> candidates(const QByteArray &key) const;
+
+  // Rewrites up to maxPostings posting lists without their removed ids.
+  // Once every list has been rewritten, the ids removed before the sweep
+  // started no longer count as removed.
+  void compact(int maxPostings);
+
+  bool isLive(DocId id) const;
+  int  liveCount() const;
+  int  removedCount() const;  // Removed ids still left in posting lists
+  int  postingCount() const;  // Amount of distinct trigrams
+  qint64 memoryUsage() const; // Bytes used by the encoded posting lists
+
+private:
+  struct Posting {
+    QByteArray deltas;
+    DocId last=0;
+    int count=0;
+  };
+  QHash<quint32, Posting> m_postings;
+  QVector<bool> m_live;
+  int m_liveCount=0;
+  int m_removedCount=0;
+
+  // Progress of the current compaction sweep
+  QVector<quint32> m_sweepTrigrams;
+  int m_sweepPosition=0;
+  int m_sweepRemovedCount=0;
+
+  static QVector<quint32> trigrams(const QByteArray &key);
+  static QVector<DocId> decode(const Posting &posting);
+};
+
+#endif // TRIGRAMINDEX_H
@@ -3,7 +3,7 @@
 #include <QSettings>
 
 // Defining config strings
-// ...
+#define NOTE_TEXT_MEMORY_BUDGET "note_text_memory_budget" // In bytes
 // Defining meta config strings
 #define LAST_OPENED_WINDOW_SIZE "last_opened_window_size"
 #define MAIN_SCREEN_LAYOUT "main_screen_layout"
@@ -0,0 +1,98 @@
+#include "nodepool.h"
+#include <new>
+
+static std::size_t alignedBlockSize(std::size_t size)
+{
+  const std::size_t align = alignof(std::max_align_t);
+  if ( size < sizeof(void*) )
+    size = sizeof(void*);
+  return (size + align - 1) / align * align;
+}
+
+NodePool::NodePool(std::size_t blockSize, int blocksPerChunk) :
+  m_blockSize(alignedBlockSize(blockSize)),
+  m_blocksPerChunk(blocksPerChunk > 0 ? blocksPerChunk : 1)
+{
+}
+
+NodePool::~NodePool()
+{
+  // Blocks still alive at exit belong to objects nobody deleted; keep
+  // their memory rather than pulling it out from under them.
+  release();
+}
+
+void *NodePool::allocate()
+{
+  if ( m_free == nullptr )
+    addChunk(m_blocksPerChunk);
+
+  FreeBlock *block = m_free;
+  m_free = block->next;
+  m_live++;
+  return block;
+}
+
+void NodePool::deallocate(void *block)
+{
+  if ( block == nullptr )
+    return;
+
+  FreeBlock *freed = static_cast<FreeBlock*>(block);
+  freed->next = m_free;
+  m_free = freed;
+  m_live--;
+}
+
+void NodePool::reserve(int count)
+{
+  int available = m_capacity - m_live;
+  if ( count <= available )
+    return;
+  // Round up to whole chunks so repeated small reserves don't leave a
+  // trail of tiny chunks behind.
+  int shortfall = count - available;
+  addChunk( (shortfall + m_blocksPerChunk - 1) / m_blocksPerChunk * m_blocksPerChunk );
+}
+
+bool NodePool::release()
+{
+  if ( m_live > 0 )
+    return false;
+  releaseChunks();
+  return true;
+}
+
+int NodePool::liveCount() const
+{
+  return m_live;
+}
+
+int NodePool::capacity() const
+{
+  return m_capacity;
+}
+
+void NodePool::addChunk(int blocks)
+{
+  char *chunk = static_cast<char*>( ::operator new(m_blockSize * blocks) );
+  m_chunks.append(chunk);
+  m_capacity += blocks;
+
+  // Thread the new blocks onto the free list in address order, so they
+  // are handed out front to back.
+  for (int i = blocks-1; i >= 0; i--) {
+    FreeBlock *block = reinterpret_cast<FreeBlock*>(chunk + i * m_blockSize);
+    block->next = m_free;
+    m_free = block;
+  }
+}
+
+void NodePool::releaseChunks()
+{
+  for (char *chunk : m_chunks)
+    ::operator delete(chunk);
+  m_chunks.clear();
+  m_free = nullptr;
+  m_capacity = 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * NodePool
+ * Hands out fixed size blocks of memory carved from large chunks, so the
+ * notebooks, tags and tree items loaded at startup end up next to each
+ * other instead of scattered across the heap. Freed blocks are kept on a
+ * free list and handed out again. The chunks themselves are only given
+ * back by release(), once nothing allocated from the pool is alive.
+ *
+ * Classes opt in by overriding operator new and delete. (see Notebook)
+ * Pools are only used from the GUI thread.
+ */
+
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+#include <QVector>
+#include <cstddef>
+
+#define NODE_POOL_CHUNK_SIZE 256 // Blocks per chunk
+
+class NodePool
+{
+public:
+  explicit NodePool(std::size_t blockSize, int blocksPerChunk = NODE_POOL_CHUNK_SIZE);
+  ~NodePool();
+
+  NodePool(const NodePool&) = delete;
+  NodePool &operator=(const NodePool&) = delete;
+
+  void *allocate();
+  void  deallocate(void *block);
+
+  // Makes room for count more blocks in a single chunk, so a tree about
+  // to be loaded ends up in one contiguous piece of memory. The chunk is
+  // rounded up to a whole number of regular chunks.
+  void reserve(int count);
+
+  // Frees every chunk if no block is in use. Returns false, and keeps
+  // the memory, while any block is still alive.
+  bool release();
+
+  int liveCount() const;
+  int capacity() const;
+
+private:
+  struct FreeBlock { FreeBlock *next; };
+
+  void addChunk(int blocks);
+  void releaseChunks();
+
+  std::size_t         m_blockSize;
+  int                 m_blocksPerChunk;
+  int                 m_live = 0;
+  int                 m_capacity = 0;
+  FreeBlock          *m_free = nullptr;
+  QVector<char*>      m_chunks;
+};
+
+#endif // NODEPOOL_H
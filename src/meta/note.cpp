@@ -6,18 +6,17 @@
 
 Note::Note(QUuid sync_hash, QString title, QString text, QDateTime date_created, QDateTime date_modified, QUuid notebook, QVector<QUuid> tags, bool favorited, bool encrypted, bool trashed) :
   m_sync_hash(sync_hash),
-  m_title(title),
   m_text(text),
-  m_date_created(date_created),
-  m_date_modified(date_modified),
-  m_notebook(notebook),
-  m_tags(tags),
-  m_favorited(favorited),
-  m_encrypted(encrypted),
-  m_trashed(trashed)
+  m_fields(new Fields{title, date_created, date_modified, notebook, tags, favorited, encrypted, trashed})
 {
-  connect(this, &Note::changed,
-          this, &Note::handleChange);
+}
+
+Note::~Note()
+{
+  // Don't leave the store's row pointing at a deleted note.
+  if ( m_store != nullptr )
+    m_store->remove(m_storeRow);
+  delete m_fields;
 }
 
 QUuid Note::syncHash() const
@@ -30,69 +29,114 @@ void Note::setSyncHash(QUuid sync_hash)
   if (m_sync_hash == sync_hash)
     return;
   m_sync_hash = sync_hash;
-  emit changed( this, false );
+  emit syncHashChanged(this);
+  notifyChanged(false);
+}
+
+QByteArray Note::searchKey() const
+{
+  if ( !m_search_key_valid ) {
+    m_search_key = HelperIO::searchKey(title());
+    m_search_key_valid = true;
+  }
+  return m_search_key;
 }
 
 QString Note::title() const
 {
-  return m_title;
+  return m_store ? m_store->title(m_storeRow) : m_fields->title;
 }
 
 void Note::setTitle(const QString title)
 {
   QString titleCleaned = title.trimmed();
   // If no changed to title or it is empty, return.
-  if (m_title == titleCleaned ||
+  if (this->title() == titleCleaned ||
       title.isEmpty())
     return;
-  m_title = titleCleaned;
-  emit changed( this );
+  if ( m_store ) m_store->setTitle(m_storeRow, titleCleaned);
+  else           m_fields->title = titleCleaned;
+  m_search_key_valid = false;
+  notifyChanged();
   emit titleChanged( this );
 }
 
 QString Note::text() const
 {
+  if ( !m_text_loaded )
+    emit const_cast<Note*>(this)->textRequested( const_cast<Note*>(this) );
   return m_text;
 }
 
 void Note::setText(const QString text)
 {
   QString textCleaned = text.trimmed();
-  if (!QString::compare(m_text, textCleaned)) // If m_text and text are the same, exit
+  if (m_text_loaded && !QString::compare(m_text, textCleaned)) // If m_text and text are the same, exit
     return;
   m_text = textCleaned;
-  emit changed( this );
+  m_text_loaded = true;
+  notifyChanged();
   emit textChanged( this );
 }
 
+QString Note::excerpt() const
+{
+  if ( !m_text_loaded )
+    return m_excerpt;
+  return m_text.left(NOTE_EXCERPT_LENGTH);
+}
+
+bool Note::textLoaded() const
+{
+  return m_text_loaded;
+}
+
+void Note::setText_primitive(const QString text)
+{
+  m_text = text;
+  m_text_loaded = true;
+}
+
+void Note::unloadText()
+{
+  m_excerpt = m_text.left(NOTE_EXCERPT_LENGTH);
+  m_text = QString();
+  m_text_loaded = false;
+}
+
 QDateTime Note::dateCreated() const
 {
-  return m_date_created;
+  if ( m_store )
+    return QDateTime::fromMSecsSinceEpoch( m_store->dateCreated(m_storeRow) );
+  return m_fields->dateCreated;
 }
 
 QString Note::dateCreatedStr() const
 {
-  return m_date_created.toString("MMMM d, yyyy");
+  return dateCreated().toString("MMMM d, yyyy");
 }
 
 QString Note::dateCreatedStrInformative() const
 {
-  return informativeDate( m_date_created );
+  return informativeDate( dateCreated() );
 }
 
 void Note::setDateCreated(const QDateTime &date_created)
 {
-  if (!QString::compare(m_date_created.toString(), date_created.toString())) // If dates are same, exit
+  if (!QString::compare(dateCreated().toString(), date_created.toString())) // If dates are same, exit
     return;
-  m_date_created = date_created;
-  emit changed( this, false );
+  if ( m_store ) m_store->setDateCreated(m_storeRow, date_created.toMSecsSinceEpoch());
+  else           m_fields->dateCreated = date_created;
+  notifyChanged(false);
   emit dateCreatedChanged( this );
 }
 
 
 QDateTime Note::dateModified() const
 {
-  return m_date_modified;
+  if ( m_store )
+    return QDateTime::fromMSecsSinceEpoch( m_store->dateModified(m_storeRow) );
+  return m_fields->dateModified;
 }
 
 QString Note::dateModifiedStr()
@@ -103,9 +147,10 @@ QString Note::dateModifiedStr()
 #else
   QDateTime currentDateTime = QDateTime::currentDateTime();
 #endif
+  QDateTime date_modified = dateModified();
 
   // Time difference in seconds
-  int td_sec = static_cast<int>(currentDateTime.toSecsSinceEpoch() - m_date_modified.toSecsSinceEpoch());
+  int td_sec = static_cast<int>(currentDateTime.toSecsSinceEpoch() - date_modified.toSecsSinceEpoch());
   int secs_in_minute = 60;
   int secs_in_hour   = 3600;
   int secs_in_year   = 31557600;
@@ -120,8 +165,8 @@ QString Note::dateModifiedStr()
     unit = "year";
     diviser = secs_in_year;
   }
-  else if ( currentDateTime.date().month() != m_date_modified.date().month() ) {
-    int m = m_date_modified.date().month();
+  else if ( currentDateTime.date().month() != date_modified.date().month() ) {
+    int m = date_modified.date().month();
     int months_since = 0;
     while ( m != currentDateTime.date().month() ) {
       months_since++;
@@ -151,81 +196,101 @@ QString Note::dateModifiedStr()
 
 QString Note::dateModifiedStrInformative()
 {
-  return informativeDate( m_date_modified );
+  return informativeDate( dateModified() );
 }
 
 void Note::setDateModified(const QDateTime &date_modified)
 {
-  if (!QString::compare(m_date_modified.toString(), date_modified.toString())) // If dates are same, exit
+  if (!QString::compare(dateModified().toString(), date_modified.toString())) // If dates are same, exit
     return;
-  m_date_modified = date_modified;
-  emit changed( this, false );
+  if ( m_store ) m_store->setDateModified(m_storeRow, date_modified.toMSecsSinceEpoch());
+  else           m_fields->dateModified = date_modified;
+  notifyChanged(false);
   emit dateModifiedChanged( this );
 }
 
 QUuid Note::notebook() const
 {
-  return m_notebook;
+  if ( m_store )
+    return syncHashInterner()->syncHash( m_store->notebook(m_storeRow) );
+  return m_fields->notebook;
 }
 
 void Note::setNotebook(QUuid sync_hash, bool updateDateModified)
 {
-  if (m_notebook == sync_hash)
+  if (notebook() == sync_hash)
     return;
-  m_notebook = sync_hash;
-  emit changed( this, updateDateModified );
+  if ( m_store ) m_store->setNotebook(m_storeRow, syncHashInterner()->intern(sync_hash));
+  else           m_fields->notebook = sync_hash;
+  notifyChanged(updateDateModified);
   emit notebookChanged( this );
 }
 
 QVector<QUuid> Note::tags() const
 {
-  return m_tags;
+  if ( !m_store )
+    return m_fields->tags;
+  QVector<QUuid> tags;
+  for ( NoteStore::Id tag : m_store->tags(m_storeRow) )
+    tags.append( syncHashInterner()->syncHash(tag) );
+  return tags;
 }
 
 void Note::setTags(const QVector<QUuid> &tags)
 {
-  m_tags = tags;
-  emit changed( this );
+  if ( m_store ) {
+    QVector<NoteStore::Id> ids;
+    ids.reserve(tags.size());
+    for ( QUuid tag : tags )
+      ids.append( syncHashInterner()->intern(tag) );
+    m_store->setTags(m_storeRow, ids);
+  }
+  else
+    m_fields->tags = tags;
+  notifyChanged();
   emit tagsChanged( this );
 }
 
 bool Note::favorited() const
 {
-  return m_favorited;
+  return m_store ? m_store->favorited(m_storeRow) : m_fields->favorited;
 }
 
 void Note::setFavorited(bool favorited)
 {
-  if (m_favorited == favorited)
+  if (this->favorited() == favorited)
     return;
-  m_favorited = favorited;
-  emit changed( this, false );
+  if ( m_store ) m_store->setFlag(m_storeRow, NoteStore::Favorited, favorited);
+  else           m_fields->favorited = favorited;
+  notifyChanged(false);
   emit favoritedChanged( this );
 }
 
 bool Note::encrypted() const
 {
-  return m_encrypted;
+  return m_store ? m_store->encrypted(m_storeRow) : m_fields->encrypted;
 }
 
 void Note::setEncrypted(bool encrypted)
 {
-  if (encrypted == m_encrypted)
+  if (encrypted == this->encrypted())
     return;
-  m_encrypted = encrypted;
-  emit changed(this, true);
+  if ( m_store ) m_store->setFlag(m_storeRow, NoteStore::Encrypted, encrypted);
+  else           m_fields->encrypted = encrypted;
+  notifyChanged(true);
   emit encryptedChanged(this);
 }
 
 bool Note::trashed() const {
-  return m_trashed;
+  return m_store ? m_store->trashed(m_storeRow) : m_fields->trashed;
 }
 
 void Note::setTrashed(bool _trashed) {
-  if (_trashed == m_trashed)
+  if (_trashed == trashed())
     return;
-  m_trashed = _trashed;
-  emit changed(this, false);
+  if ( m_store ) m_store->setFlag(m_storeRow, NoteStore::Trashed, _trashed);
+  else           m_fields->trashed = _trashed;
+  notifyChanged(false);
   emit trashedOrRestored(this, _trashed);
   if ( _trashed ) emit trashed(this);
   else           emit restored(this);
@@ -268,8 +333,11 @@ bool Note::byDateModifiedDesc(const Note *n1, const Note *n2)
   return compareTwoDateTimes( n1->dateModified(), n2->dateModified(), '>' );
 }
 
-void Note::handleChange(Note *note, bool updateDateModified)
+void Note::notifyChanged(bool updateDateModified)
 {
+  // Done here rather than in a slot connected to changed, which cost every
+  // note a connection of its own.
   if ( updateDateModified )
-    note->setDateModified( QDateTime::currentDateTime() );
+    setDateModified( QDateTime::currentDateTime() );
+  emit changed( this, updateDateModified );
 }
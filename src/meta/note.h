@@ -5,8 +5,11 @@
 #include <QUuid>
 #include "notebook.h"
 #include "tag.h"
+#include "db/notestore.h"
 
 #define NOTE_DEFAULT_TITLE "Untitled Note"
+// Amount of characters kept in memory for notes whose text is not loaded.
+#define NOTE_EXCERPT_LENGTH 100
 
 class Note : public QObject
 {
@@ -25,6 +28,7 @@ public:
        // TODO: public field
        bool encrypted = false,
        bool trashed = false);
+  ~Note();
 
   // Sync Hash
   QUuid syncHash() const;
@@ -33,10 +37,22 @@ public:
   // Title
   QString title() const;
   void    setTitle(const QString title);
+  // Folded form of the title that searches match against. (see HelperIO::searchKey)
+  // Computed on first use and again after the title changes.
+  QByteArray searchKey() const;
 
   // Text
+  // If the text is not loaded, text() emits textRequested so that
+  // the note database can fetch it from SQL.
   QString text() const;
   void    setText(const QString text);
+  QString excerpt() const;
+  bool    textLoaded() const;
+
+  // These functions do not emit change signals. They are used by the
+  // note database to load the text on demand and drop it again.
+  void setText_primitive(const QString text);
+  void unloadText();
 
   // Date created
   QDateTime dateCreated() const;
@@ -83,6 +99,7 @@ signals:
   void syncHashChanged(Note *note);
   void titleChanged(Note *note);
   void textChanged(Note *note);
+  void textRequested(Note *note);
   void dateCreatedChanged(Note *note);
   void dateModifiedChanged(Note *note);
   void notebookChanged(Note *note);
@@ -93,22 +110,37 @@ signals:
   void restored(Note *note);
   void trashedOrRestored(Note *note, bool _trashed);
 
-private slots:
-  void handleChange(Note *note, bool updateDateModified=true);
+private:
+  // Bumps the modification date if asked to, then emits changed.
+  void notifyChanged(bool updateDateModified=true);
 
 private:
   QUuid        m_sync_hash;
-  QString      m_title;
+  mutable QByteArray m_search_key;
+  mutable bool       m_search_key_valid=false;
   QString      m_text;
-  QDateTime    m_date_created;
-  QDateTime    m_date_modified;
-  QUuid          m_notebook;
-  QVector<QUuid> m_tags;
-  // TODO: Private user variable
-  bool         m_favorited;
-  // TODO: Private public variable
-  bool         m_encrypted;
-  bool         m_trashed=false;
+  QString      m_excerpt;
+  bool         m_text_loaded=true;
+
+  // The fields the note list filters and sorts on. Once the note is added
+  // to a NoteStore they move into its columns and are read from its row.
+  // Until then, and after it is removed, the note holds them in m_fields.
+  struct Fields {
+    QString        title;
+    QDateTime      dateCreated;
+    QDateTime      dateModified;
+    QUuid          notebook;
+    QVector<QUuid> tags;
+    // TODO: Private user variable
+    bool           favorited;
+    // TODO: Private public variable
+    bool           encrypted;
+    bool           trashed;
+  };
+  Fields        *m_fields;
+  NoteStore     *m_store=nullptr;
+  NoteStore::Row m_storeRow=NOTE_STORE_NO_ROW;
+  friend class NoteStore;
 
   QString informativeDate(QDateTime date) const;
 };
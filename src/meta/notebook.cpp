@@ -1,4 +1,5 @@
 #include "notebook.h"
+#include "nodepool.h"
 #include <QDebug>
 
 Notebook::Notebook(QUuid sync_hash, QString title, QDateTime date_modified, Notebook *parent, int row, bool encrypted) :
@@ -13,6 +14,39 @@ Notebook::Notebook(QUuid sync_hash, QString title, QDateTime date_modified, Note
           this, &Notebook::handleChange);
 }
 
+static NodePool *notebookPool()
+{
+  // Never destroyed, so objects deleted during shutdown still find it.
+  static NodePool *pool = new NodePool(sizeof(Notebook));
+  return pool;
+}
+
+void *Notebook::operator new(std::size_t size)
+{
+  // Subclasses don't fit the pool's blocks.
+  if ( size != sizeof(Notebook) )
+    return ::operator new(size);
+  return notebookPool()->allocate();
+}
+
+void Notebook::operator delete(void *block, std::size_t size)
+{
+  if ( size != sizeof(Notebook) )
+    ::operator delete(block);
+  else
+    notebookPool()->deallocate(block);
+}
+
+void Notebook::reservePool(int count)
+{
+  notebookPool()->reserve(count);
+}
+
+void Notebook::releasePool()
+{
+  notebookPool()->release();
+}
+
 Notebook *Notebook::createBlankNotebook()
 {
   return new Notebook(QUuid::createUuid(), NOTEBOOK_DEFAULT_TITLE);
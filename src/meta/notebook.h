@@ -5,6 +5,7 @@
 #include <QObject>
 #include <QUuid>
 #include <QDateTime>
+#include <cstddef>
 
 #define NOTEBOOK_DEFAULT_TITLE "Untitled Notebook"
 
@@ -21,6 +22,14 @@ public:
 
   static Notebook *createBlankNotebook();
 
+  // Notebooks are allocated from a NodePool, so a loaded tree sits in one
+  // chunk of memory. reservePool() makes room ahead of a load, and
+  // releasePool() hands the memory back once every notebook is gone.
+  static void *operator new(std::size_t size);
+  static void  operator delete(void *block, std::size_t size);
+  static void  reservePool(int count);
+  static void  releasePool();
+
   // Sync Hash
   QUuid syncHash() const;
   void setSyncHash(QUuid syncHash);
@@ -1,4 +1,5 @@
 #include "tag.h"
+#include "nodepool.h"
 
 Tag::Tag(QUuid sync_hash, QString title, QDateTime date_modified, int row, bool encrypted) :
   m_sync_hash(sync_hash),
@@ -11,6 +12,37 @@ Tag::Tag(QUuid sync_hash, QString title, QDateTime date_modified, int row, bool
           this, &Tag::handleChange);
 }
 
+static NodePool *tagPool()
+{
+  static NodePool *pool = new NodePool(sizeof(Tag));
+  return pool;
+}
+
+void *Tag::operator new(std::size_t size)
+{
+  if ( size != sizeof(Tag) )
+    return ::operator new(size);
+  return tagPool()->allocate();
+}
+
+void Tag::operator delete(void *block, std::size_t size)
+{
+  if ( size != sizeof(Tag) )
+    ::operator delete(block);
+  else
+    tagPool()->deallocate(block);
+}
+
+void Tag::reservePool(int count)
+{
+  tagPool()->reserve(count);
+}
+
+void Tag::releasePool()
+{
+  tagPool()->release();
+}
+
 QUuid Tag::syncHash() const
 {
   return m_sync_hash;
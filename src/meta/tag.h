@@ -4,6 +4,7 @@
 #include <QString>
 #include <QUuid>
 #include <QDateTime>
+#include <cstddef>
 
 #define TAG_DEFAULT_TITLE "Untitled Tag"
 
@@ -17,6 +18,12 @@ public:
       int       row           = -255,
       bool      encrypted     = false);
 
+  // Allocated from a pool shared by every tag. (see NodePool)
+  static void *operator new(std::size_t size);
+  static void  operator delete(void *block, std::size_t size);
+  static void  reservePool(int count);
+  static void  releasePool();
+
   // Sync Hash
   QUuid syncHash() const;
   void setSyncHash(QUuid syncHash);
@@ -4,13 +4,77 @@
 #include <QApplication>
 #include <QMouseEvent>
 #include <QAbstractItemModel>
+#include <QFontMetrics>
+#include <QIcon>
 #include "../items/notelistitem.h"
 
-NoteItemDelegate::NoteItemDelegate(QListView *view, QSortFilterProxyModel *proxyModel) :
+NoteItemDelegate::NoteItemDelegate(QListView *view, QSortFilterProxyModel *proxyModel, NoteDatabase *noteDatabase) :
   m_view(view),
-  m_proxyModel(proxyModel)
+  m_proxyModel(proxyModel),
+  m_renderCache(NOTE_RENDER_CACHE_SIZE)
 {
+  connect(noteDatabase, &NoteDatabase::noteChanged,
+          this, &NoteItemDelegate::forgetNote);
+  connect(noteDatabase, &NoteDatabase::noteAboutToBeDeleted,
+          this, &NoteItemDelegate::forgetNote);
+}
+
+void NoteItemDelegate::forgetNote(Note *note)
+{
+  m_renderCache.remove(note);
+}
+
+NoteItemDelegate::RenderedNote *NoteItemDelegate::rendered(Note *note, const QFont &font, int width) const
+{
+  if ( font != m_renderFont || width != m_renderWidth ) {
+    m_renderCache.clear();
+    m_renderFont = font;
+    m_renderWidth = width;
+  }
+
+  RenderedNote *r = m_renderCache.object(note);
+  if ( r != nullptr )
+    return r;
+
+  r = new RenderedNote;
+  r->title.setTextFormat(Qt::PlainText);
+  r->date.setTextFormat(Qt::PlainText);
+  r->excerpt.setTextFormat(Qt::PlainText);
+
+  QString excerpt = note->excerpt();
+  if (excerpt.length() > NOTE_RENDER_EXCERPT_LENGTH) {
+    excerpt = excerpt.mid(0, NOTE_RENDER_EXCERPT_LENGTH) + "...";
+  }
+  excerpt = excerpt.simplified(); // Ensure at most one space
+
+  QFont bold = font;
+  bold.setWeight(QFont::Bold);
+  r->title.setText(note->title());
+  r->title.prepare(QTransform(), bold);
+  r->titleAscent = QFontMetrics(bold).ascent();
+
+  r->date.setText(note->dateCreatedStr());
+  r->date.prepare(QTransform(), font);
+  r->dateAscent = QFontMetrics(font).ascent();
+
+  r->excerpt.setText(excerpt);
+  r->excerpt.prepare(QTransform(), font);
 
+  m_renderCache.insert(note, r);
+  return r;
+}
+
+const QPixmap &NoteItemDelegate::star(bool solid, qreal pixelRatio) const
+{
+  if ( pixelRatio != m_starPixelRatio ) {
+    QSize size = QSize(25,25) * pixelRatio;
+    m_star = QIcon::fromTheme("vibrato-draw-star").pixmap(size);
+    m_star.setDevicePixelRatio(pixelRatio);
+    m_starSolid = QIcon::fromTheme("vibrato-draw-star-solid").pixmap(size);
+    m_starSolid.setDevicePixelRatio(pixelRatio);
+    m_starPixelRatio = pixelRatio;
+  }
+  return solid ? m_starSolid : m_star;
 }
 
 QRect NoteItemDelegate::getStarRect(const QStyleOptionViewItem &option) const
@@ -65,37 +129,27 @@ void NoteItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     else
       painter->setPen(option.palette.text().color());
 
-    QRect titleRect = option.rect;
-    titleRect.setX(titleRect.x()+5);
-    titleRect.setWidth(titleRect.x()-5);
-
     QFont font=painter->font() ;
     font.setPointSize(10);
+    font.setWeight(QFont::Normal);
+
+    // The text was laid out with these fonts, so drawing it again is cheap
+    // as long as the painter uses the same ones.
+    RenderedNote *r = rendered(item->note(), font, option.rect.width());
 
     // Title
-    font.setWeight(QFont::Bold);
-    painter->setFont(font);
-    painter->drawText(QPoint(option.rect.x()+10, option.rect.y()+23), item->note()->title());
+    QFont bold = font;
+    bold.setWeight(QFont::Bold);
+    painter->setFont(bold);
+    painter->drawStaticText(option.rect.x()+10, option.rect.y()+23-r->titleAscent, r->title);
 
     // Date
-    font.setWeight(QFont::Normal);
     painter->setFont(font);
-    painter->drawText(QPoint(option.rect.x()+10, option.rect.y()+43), item->note()->dateCreatedStr());
-
+    painter->drawStaticText(option.rect.x()+10, option.rect.y()+43-r->dateAscent, r->date);
 
     // The Excerpt
-    QRect excerptRect = option.rect;
-    excerptRect.setX( excerptRect.x()+10 );
-    excerptRect.setY( excerptRect.y()+50 );
-    excerptRect.setWidth( excerptRect.width()-50 );
-
-    QString excerpt = item->note()->text();
-    if (excerpt.length() > 50) {
-      excerpt = excerpt.mid(0, 50) + "...";
-    }
-    excerpt.replace("\n", " ");
-    excerpt.replace(QRegExp("\\s\\s+"), " "); // Ensure at most one space
-    painter->drawText(excerptRect, excerpt);
+    // It is one short line, anything running into the star gets covered below.
+    painter->drawStaticText(option.rect.x()+10, option.rect.y()+50, r->excerpt);
 
     painter->fillRect(QRect(
                             option.rect.x() + option.rect.width() - 60,
@@ -103,13 +157,13 @@ void NoteItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
                             60,
                             option.rect.height()), background);
 
-    QIcon favoriteIcon;
-    if (item->note()->favorited())
-      favoriteIcon = QIcon::fromTheme("vibrato-draw-star-solid");
-    else
-      favoriteIcon = QIcon::fromTheme("vibrato-draw-star");
-
-    favoriteIcon.paint(painter, getStarRect(option));
+    // Center the star in its rect, like QIcon::paint did.
+    const QPixmap &favoriteIcon = star(item->note()->favorited(), painter->device()->devicePixelRatioF());
+    QRect starRect = getStarRect(option);
+    QSize starSize = favoriteIcon.size() / favoriteIcon.devicePixelRatio();
+    painter->drawPixmap(starRect.x() + (starRect.width() - starSize.width())/2,
+                        starRect.y() + (starRect.height() - starSize.height())/2,
+                        favoriteIcon);
 
   } else {
     QStyledItemDelegate::paint(painter, option, index);
@@ -3,11 +3,21 @@
 #include <QStyledItemDelegate>
 #include <QListView>
 #include <QSortFilterProxyModel>
+#include <QStaticText>
+#include <QPixmap>
+#include <QCache>
+#include "../../meta/db/notedatabase.h"
+
+// Amount of notes whose rendered text is kept around.
+#define NOTE_RENDER_CACHE_SIZE 512
+
+// Length of the excerpt shown under the date, before the "..."
+#define NOTE_RENDER_EXCERPT_LENGTH 50
 
 class NoteItemDelegate : public QStyledItemDelegate
 {
 public:
-    NoteItemDelegate(QListView *view, QSortFilterProxyModel *proxyModel);
+    NoteItemDelegate(QListView *view, QSortFilterProxyModel *proxyModel, NoteDatabase *noteDatabase);
 
     QRect getStarRect(const QStyleOptionViewItem &option) const;
 
@@ -22,10 +32,34 @@ public:
     QSize sizeHint(const QStyleOptionViewItem &option,
                    const QModelIndex &index) const override;
 
+    // Drops the rendered text of a note, so it is laid out again on the next paint.
+    void forgetNote(Note *note);
+
 private:
     bool checked = false;
     QListView *m_view;
     QSortFilterProxyModel *m_proxyModel;
+
+    // Text of a row, laid out once and reused until the note changes.
+    struct RenderedNote {
+      QStaticText title;
+      QStaticText date;
+      QStaticText excerpt;
+      int titleAscent;
+      int dateAscent;
+    };
+    mutable QCache<Note*, RenderedNote> m_renderCache;
+    // Font and row width the cached text was laid out for. The cache is
+    // dropped when either changes.
+    mutable QFont m_renderFont;
+    mutable int m_renderWidth=-1;
+    RenderedNote *rendered(Note *note, const QFont &font, int width) const;
+
+    // Star icons, rendered for the device pixel ratio they were last painted at.
+    mutable qreal m_starPixelRatio=0;
+    mutable QPixmap m_star;
+    mutable QPixmap m_starSolid;
+    const QPixmap &star(bool solid, qreal pixelRatio) const;
 };
 
 #endif // MYDELEGATE_H
@@ -0,0 +1,83 @@
+#include "trashitemdelegate.h"
+#include <QPainter>
+#include <QMouseEvent>
+
+TrashItemDelegate::TrashItemDelegate(TrashListModel *model, NoteDatabase *noteDatabase, QObject *parent) :
+  QStyledItemDelegate(parent),
+  m_model(model),
+  m_noteDatabase(noteDatabase),
+  m_restoreIcon(QIcon::fromTheme("document-revert")),
+  m_deleteIcon(QIcon::fromTheme("window-close"))
+{
+
+}
+
+QRect TrashItemDelegate::getRestoreRect(const QStyleOptionViewItem &option) const
+{
+  return QRect(option.rect.x()+option.rect.width()-60,
+               option.rect.y()+option.rect.height()/2-10,
+               20,20);
+}
+
+QRect TrashItemDelegate::getDeleteRect(const QStyleOptionViewItem &option) const
+{
+  return QRect(option.rect.x()+option.rect.width()-30,
+               option.rect.y()+option.rect.height()/2-10,
+               20,20);
+}
+
+bool TrashItemDelegate::editorEvent(QEvent *event,
+                                    QAbstractItemModel *model,
+                                    const QStyleOptionViewItem &option,
+                                    const QModelIndex &index)
+{
+  if (event->type() == QEvent::MouseButtonRelease) {
+    QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+    Note *note = m_model->noteFromIndex(index);
+    if ( mouseEvent->button() == Qt::LeftButton && note != nullptr ) {
+      if ( getRestoreRect(option).contains(mouseEvent->pos()) ) {
+        m_noteDatabase->restoreNotes({note});
+        return true;
+      }
+      if ( getDeleteRect(option).contains(mouseEvent->pos()) ) {
+        m_noteDatabase->removeNote(note);
+        return true;
+      }
+    }
+  }
+
+  return QStyledItemDelegate::editorEvent(event, model, option, index);
+}
+
+void TrashItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+  Note *note = m_model->noteFromIndex(index);
+  if ( note == nullptr ) {
+    QStyledItemDelegate::paint(painter, option, index);
+    return;
+  }
+
+  QBrush background =
+    (option.state & QStyle::State_Selected) ?
+    option.palette.highlight() :
+    option.palette.base();
+  painter->fillRect(option.rect, background);
+
+  if (option.state & QStyle::State_Selected)
+    painter->setPen(option.palette.highlightedText().color());
+  else
+    painter->setPen(option.palette.text().color());
+
+  // Title, cut off before the buttons
+  QRect titleRect = option.rect.adjusted(10, 0, -70, 0);
+  QString title = option.fontMetrics.elidedText(note->title(), Qt::ElideRight, titleRect.width());
+  painter->drawText(titleRect, Qt::AlignVCenter | Qt::AlignLeft, title);
+
+  m_restoreIcon.paint(painter, getRestoreRect(option));
+  m_deleteIcon.paint(painter, getDeleteRect(option));
+}
+
+QSize TrashItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+  return QSize(200, TRASH_ITEM_HEIGHT);
+}
@@ -0,0 +1,35 @@
+#ifndef TRASHITEMDELEGATE_H
+#define TRASHITEMDELEGATE_H
+#include <QStyledItemDelegate>
+#include <QIcon>
+#include "../trashlistmodel.h"
+
+#define TRASH_ITEM_HEIGHT 40
+
+class TrashItemDelegate : public QStyledItemDelegate
+{
+public:
+    TrashItemDelegate(TrashListModel *model, NoteDatabase *noteDatabase, QObject *parent = nullptr);
+
+    QRect getRestoreRect(const QStyleOptionViewItem &option) const;
+    QRect getDeleteRect(const QStyleOptionViewItem &option) const;
+
+    bool editorEvent(QEvent *event,
+                     QAbstractItemModel *model,
+                     const QStyleOptionViewItem &option,
+                     const QModelIndex &index) override;
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+
+    QSize sizeHint(const QStyleOptionViewItem &option,
+                   const QModelIndex &index) const override;
+
+private:
+    TrashListModel *m_model;
+    NoteDatabase *m_noteDatabase;
+    QIcon m_restoreIcon;
+    QIcon m_deleteIcon;
+};
+
+#endif // TRASHITEMDELEGATE_H
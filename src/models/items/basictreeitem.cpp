@@ -3,6 +3,7 @@
 #include <QFile>
 #include "basictreeitem.h"
 #include "../../meta/notebook.h"
+#include "../../meta/nodepool.h"
 #include "../../meta/info/appinfo.h"
 
 BasicTreeItem::BasicTreeItem(Notebook *notebook, BasicTreeItem *parent)
@@ -33,6 +34,32 @@ BasicTreeItem::~BasicTreeItem()
   qDeleteAll(m_childItems);
 }
 
+static NodePool *basicTreeItemPool()
+{
+  static NodePool *pool = new NodePool(sizeof(BasicTreeItem));
+  return pool;
+}
+
+void *BasicTreeItem::operator new(std::size_t size)
+{
+  if ( size != sizeof(BasicTreeItem) )
+    return ::operator new(size);
+  return basicTreeItemPool()->allocate();
+}
+
+void BasicTreeItem::operator delete(void *block, std::size_t size)
+{
+  if ( size != sizeof(BasicTreeItem) )
+    ::operator delete(block);
+  else
+    basicTreeItemPool()->deallocate(block);
+}
+
+void BasicTreeItem::reservePool(int count)
+{
+  basicTreeItemPool()->reserve(count);
+}
+
 bool BasicTreeItem::isNotebook() const
 {
   return m_type == Type_Notebook;
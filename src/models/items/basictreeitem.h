@@ -21,6 +21,12 @@ public:
 
   ~BasicTreeItem();
 
+  // Tree items come from their own NodePool. It is never released, as
+  // TreeManager keeps cleared items alive; freed blocks are reused instead.
+  static void *operator new(std::size_t size);
+  static void  operator delete(void *block, std::size_t size);
+  static void  reservePool(int count);
+
   enum TypeOfItem {Type_Notebook, Type_Tag, Type_SearchQuery, Type_NotebooksLabel, Type_TagsLabel, Type_Other};
 
   bool isNotebook() const;
@@ -1,30 +1,23 @@
 #include "notelistitem.h"
-#include "ui_notelistitem.h"
-#include <QDebug>
-#include <QPushButton>
 
-NoteListItem::NoteListItem(Note *note) :
-  m_note(note)
+NoteListItem::NoteListItem(Note *note, NoteStore::Row storeRow) :
+  m_note(note),
+  m_storeRow(storeRow)
 {
 }
 
-NoteListItem::~NoteListItem()
-{
-  m_note = nullptr;
-}
-
 Note *NoteListItem::note() const
 {
   return m_note;
 }
 
-void NoteListItem::setNote(Note *note)
+void NoteListItem::setNote(Note *note, NoteStore::Row storeRow)
 {
   m_note = note;
-  m_sync_hash = note->syncHash();
+  m_storeRow = storeRow;
 }
 
-QUuid NoteListItem::syncHash() const
+NoteStore::Row NoteListItem::storeRow() const
 {
-  return m_sync_hash;
+  return m_storeRow;
 }
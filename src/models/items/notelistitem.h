@@ -1,31 +1,28 @@
 #ifndef NOTELISTITEM_H
 #define NOTELISTITEM_H
-#include <QObject>
-#include <QListView>
-#include <QLabel>
 #include "../../meta/note.h"
+#include "../../meta/db/notestore.h"
 
 #define NOTE_LIST_ITEM_HEIGHT 90
 
-namespace Ui {
-  class NoteListItem;
-}
-
-class NoteListItem : public QObject
+/*
+ * NoteListItem
+ * A row of the note list. It is a plain handle, there is one per note.
+ * The row in the note store is what the list is filtered and sorted on.
+ */
+class NoteListItem
 {
-  Q_OBJECT
 public:
-  NoteListItem(Note *note);
-  ~NoteListItem();
+  NoteListItem(Note *note, NoteStore::Row storeRow=NOTE_STORE_NO_ROW);
 
   Note *note() const;
-  void setNote(Note *note);
+  void setNote(Note *note, NoteStore::Row storeRow);
 
-  QUuid syncHash() const;
+  NoteStore::Row storeRow() const;
 
 private:
   Note *m_note;
-  QUuid m_sync_hash;
+  NoteStore::Row m_storeRow;
 };
 
 #endif // NOTELISTITEM_H
@@ -1,5 +1,6 @@
 #include "notelistmodel.h"
 #include <QDebug>
+#include <algorithm>
 
 NoteListModel::NoteListModel(QListView *view, NoteDatabase *noteDatabase) : QAbstractItemModel()
 {
@@ -8,8 +9,10 @@ NoteListModel::NoteListModel(QListView *view, NoteDatabase *noteDatabase) : QAbs
   m_view->setStyleSheet(style);
   m_noteDatabase = noteDatabase;
 
-  connect(m_noteDatabase, &NoteDatabase::noteDeleted,
-          this, &NoteListModel::removeNoteItemWithSyncHash);
+  connect(m_noteDatabase, &NoteDatabase::noteAboutToBeDeleted,
+          this, &NoteListModel::removeNoteItem);
+  connect(m_noteDatabase, &NoteDatabase::rowsChanged,
+          this, &NoteListModel::refreshRows);
 }
 
 QVector<NoteListItem *> NoteListModel::noteItems() const
@@ -23,10 +26,44 @@ void NoteListModel::refresh(int row)
   emit dataChanged(topLeft, topLeft);
 }
 
+void NoteListModel::refreshNote(Note *note)
+{
+  int row = rowOfNote(note);
+  if ( row >= 0 )
+    refresh(row);
+}
+
+void NoteListModel::refreshRows(QVector<NoteStore::Row> storeRows)
+{
+  for (NoteStore::Row storeRow : storeRows) {
+    int row = rowOfStoreRow(storeRow, m_noteDatabase->store().note(storeRow));
+    if ( row >= 0 )
+      refresh(row);
+  }
+}
+
 void NoteListModel::clear()
 {
-  if (m_noteItems.length() > 0)
-    removeRows(0, m_noteItems.length());
+  setNotes({});
+}
+
+void NoteListModel::setNotes(const QList<Note*> &notes)
+{
+  beginResetModel();
+
+  qDeleteAll(m_noteItems);
+  m_noteItems.clear();
+  m_rows.fill(NOTE_LIST_NO_ROW);
+  m_rowBase = 0;
+
+  m_noteItems.reserve(notes.size());
+  for (Note *note : notes) {
+    m_noteItems.append( newItem(note) );
+    setRow(m_noteItems.last(), m_noteItems.length() - 1);
+  }
+  m_staleFrom = m_noteItems.length();
+
+  endResetModel();
 }
 
 NoteListItem *NoteListModel::prependItem(Note *note)
@@ -34,9 +71,12 @@ NoteListItem *NoteListModel::prependItem(Note *note)
   int newIndex = 0;
   beginInsertRows(QModelIndex(), newIndex, newIndex);
 
-  m_noteItems.prepend( new NoteListItem(nullptr));
+  m_noteItems.prepend( newItem(note) );
   NoteListItem *i = m_noteItems.at(newIndex);
-  i->setNote(note);
+  // Every other row moves down by one, which the base takes care of.
+  m_rowBase++;
+  m_staleFrom++;
+  setRow(i, newIndex);
 
   endInsertRows();
   return i;
@@ -47,22 +87,38 @@ NoteListItem *NoteListModel::appendItem(Note *note)
   int newIndex = m_noteItems.length();
   beginInsertRows(QModelIndex(), newIndex, newIndex);
 
-  m_noteItems.append( new NoteListItem(nullptr));
+  m_noteItems.append( newItem(note) );
   NoteListItem *i = m_noteItems.at(newIndex);
-  i->setNote(note);
+  setRow(i, newIndex);
+  if ( m_staleFrom == newIndex )
+    m_staleFrom++;
 
   endInsertRows();
   return i;
 }
 
-void NoteListModel::noteDateChanged(NoteListItem *item)
+void NoteListModel::appendItems(const QVector<Note*> &notes)
 {
-  for ( int i=0; i < m_noteItems.length(); i++ ) {
-    if ( m_noteItems.at(i) == item ) {
-      refresh( i );
-      break;
-    }
+  if ( notes.isEmpty() )
+    return;
+
+  int first = m_noteItems.length();
+  beginInsertRows(QModelIndex(), first, first + notes.length() - 1);
+
+  m_noteItems.reserve(first + notes.length());
+  for (Note *note : notes) {
+    m_noteItems.append( newItem(note) );
+    setRow(m_noteItems.last(), m_noteItems.length() - 1);
   }
+  if ( m_staleFrom == first )
+    m_staleFrom = m_noteItems.length();
+
+  endInsertRows();
+}
+
+void NoteListModel::noteDateChanged(NoteListItem *item)
+{
+  refreshNote(item->note());
 }
 
 bool NoteListModel::insertRows(int position, int rows, const QModelIndex &parent)
@@ -71,6 +127,7 @@ bool NoteListModel::insertRows(int position, int rows, const QModelIndex &parent
 
   for (int i = 0; i < rows; i++)
     m_noteItems.insert(position+i, new NoteListItem(nullptr));
+  markStale(position);
 
   endInsertRows();
 
@@ -82,10 +139,18 @@ bool NoteListModel::removeRows(int position, int rows, const QModelIndex &parent
   beginRemoveRows(parent, position, position + rows - 1);
 
   for (int i = 0; i < rows; i++) {
+    if ( m_noteItems[position]->storeRow() != NOTE_STORE_NO_ROW )
+      m_rows[ m_noteItems[position]->storeRow() ] = NOTE_LIST_NO_ROW;
     delete m_noteItems[position];
     m_noteItems[position] = nullptr;
     m_noteItems.remove(position);
   }
+  if ( position == 0 ) {
+    // Everything left moves up, which the base takes care of.
+    m_rowBase -= rows;
+    m_staleFrom = qMax(0, m_staleFrom - rows);
+  } else
+    markStale(position);
 
   endRemoveRows();
 
@@ -153,10 +218,70 @@ int NoteListModel::rowCount(const QModelIndex &parent) const
   return m_noteItems.length();
 }
 
-void NoteListModel::removeNoteItemWithSyncHash(QUuid syncHash)
+QModelIndex NoteListModel::indexOfNote(Note *note) const
 {
-  for (int i=0; i<m_noteItems.length(); i++) {
-    if ( m_noteItems.at(i)->syncHash() == syncHash)
-      removeRow(i);
+  int row = rowOfNote(note);
+  return row >= 0 ? createIndex(row, 0, m_noteItems.at(row)) : QModelIndex();
+}
+
+void NoteListModel::removeNoteItem(Note *note)
+{
+  int row = rowOfNote(note);
+  if ( row >= 0 )
+    removeRow(row);
+}
+
+NoteListItem *NoteListModel::newItem(Note *note)
+{
+  int known = m_rows.size();
+  if ( known < m_noteDatabase->store().capacity() ) {
+    m_rows.resize( m_noteDatabase->store().capacity() );
+    std::fill(m_rows.begin() + known, m_rows.end(), NOTE_LIST_NO_ROW);
+  }
+  return new NoteListItem(note, m_noteDatabase->storeRow(note));
+}
+
+int NoteListModel::rowOfNote(Note *note) const
+{
+  return rowOfStoreRow(m_noteDatabase->storeRow(note), note);
+}
+
+int NoteListModel::rowOfStoreRow(NoteStore::Row storeRow, Note *note) const
+{
+  if ( note == nullptr || storeRow == NOTE_STORE_NO_ROW ||
+       storeRow >= static_cast<NoteStore::Row>(m_rows.size()) )
+    return -1;
+
+  // Store rows get reused and rows past m_staleFrom may have moved, so
+  // make sure it is still the same note before trusting the row.
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if ( m_rows.at(storeRow) == NOTE_LIST_NO_ROW )
+      return -1;
+    int row = m_rows.at(storeRow) + m_rowBase;
+    if ( row >= 0 && row < m_noteItems.length() && m_noteItems.at(row)->note() == note )
+      return row;
+    if ( m_staleFrom >= m_noteItems.length() )
+      return -1;
+    updateStaleRows();
   }
+  return -1;
+}
+
+void NoteListModel::setRow(NoteListItem *item, int row)
+{
+  if ( item->storeRow() != NOTE_STORE_NO_ROW )
+    m_rows[ item->storeRow() ] = row - m_rowBase;
+}
+
+void NoteListModel::markStale(int from)
+{
+  m_staleFrom = qMin(m_staleFrom, from);
+}
+
+void NoteListModel::updateStaleRows() const
+{
+  for (int i = m_staleFrom; i < m_noteItems.length(); i++)
+    if ( m_noteItems.at(i)->storeRow() != NOTE_STORE_NO_ROW )
+      m_rows[ m_noteItems.at(i)->storeRow() ] = i - m_rowBase;
+  m_staleFrom = m_noteItems.length();
 }
@@ -2,9 +2,13 @@
 #define NOTELISTMODEL_H
 #include <QAbstractItemModel>
 #include <QListView>
+#include <QVector>
+#include <climits>
 #include "items/notelistitem.h"
 #include "../meta/db/notedatabase.h"
 
+#define NOTE_LIST_NO_ROW INT_MIN
+
 class NoteListModel : public QAbstractItemModel
 {
   Q_OBJECT
@@ -14,9 +18,13 @@ public:
   QVector<NoteListItem*> noteItems() const;
 
   void refresh(int row);
+  void refreshNote(Note *note);
   void clear();
   NoteListItem *prependItem(Note *note);
   NoteListItem *appendItem(Note *note);
+  void appendItems(const QVector<Note*> &notes);
+  // Replaces every item in one model reset, so views sort only once.
+  void setNotes(const QList<Note*> &notes);
 
   void noteDateChanged(NoteListItem *item);
 
@@ -37,13 +45,31 @@ public:
   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
   Note *noteFromIndex(QModelIndex index);
+  QModelIndex indexOfNote(Note *note) const;
 
-  void removeNoteItemWithSyncHash(QUuid syncHash);
+  void removeNoteItem(Note *note);
+  void refreshRows(QVector<NoteStore::Row> storeRows);
 
 private:
   QListView *m_view;
   QVector<NoteListItem*> m_noteItems;
   NoteDatabase *m_noteDatabase;
+
+  // Row of every note in m_noteItems by its row in the note store, minus
+  // m_rowBase, or NOTE_LIST_NO_ROW if it is not in the list. Prepending
+  // or removing at the top only moves m_rowBase. Other inserts and removes
+  // mark the rows from that point on as stale, and those are recomputed
+  // the next time a lookup runs into one of them.
+  mutable QVector<int> m_rows;
+  mutable int m_staleFrom=0;
+  int m_rowBase=0;
+
+  NoteListItem *newItem(Note *note);
+  int  rowOfNote(Note *note) const;
+  int  rowOfStoreRow(NoteStore::Row storeRow, Note *note) const;
+  void setRow(NoteListItem *item, int row);
+  void markStale(int from);
+  void updateStaleRows() const;
 };
 
 #endif // NOTELISTMODEL_H
@@ -0,0 +1,152 @@
+#include "fuzzymatcher.h"
+#include <QVarLengthArray>
+#include <algorithm>
+#include <climits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Same weights as fts::fuzzy_match, so scores stay comparable. Its camel
+// case bonus is left out: titles are matched as case folded search keys,
+// so there is no case left to find word boundaries with.
+#define FUZZY_SEQUENTIAL_BONUS         15 // Match right after the previous one
+#define FUZZY_SEPARATOR_BONUS          30 // Match after a space or underscore
+#define FUZZY_FIRST_LETTER_BONUS       15 // Match on the first letter
+#define FUZZY_LEADING_LETTER_PENALTY   -5 // Per letter before the first match...
+#define FUZZY_MAX_LEADING_PENALTY     -15 // ...up to this much
+#define FUZZY_UNMATCHED_LETTER_PENALTY -1 // Per letter that isn't matched
+
+static inline char foldCase(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Finds the first occurrence of the (lower case) character c in
+// str[from, length), ignoring ASCII case. Returns length if there is none.
+static inline int findFolded(const char *str, int from, int length, char c)
+{
+  int i = from;
+#ifdef __SSE2__
+  // Lower case 16 bytes at a time by adding 0x20 to the bytes in 'A'..'Z',
+  // then compare all of them against c at once.
+  const __m128i needle = _mm_set1_epi8(c);
+  const __m128i upperA = _mm_set1_epi8('A' - 1);
+  const __m128i upperZ = _mm_set1_epi8('Z' + 1);
+  const __m128i caseBit = _mm_set1_epi8(0x20);
+  for ( ; i + 16 <= length; i += 16 ) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, upperA), _mm_cmplt_epi8(block, upperZ));
+    block = _mm_or_si128(block, _mm_and_si128(upper, caseBit));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+    if ( mask != 0 ) {
+      int offset = 0;
+      while ( !(mask & (1 << offset)) )
+        offset++;
+      return i + offset;
+    }
+  }
+#endif
+  for ( ; i < length; i++ )
+    if ( foldCase(str[i]) == c )
+      return i;
+  return length;
+}
+
+FuzzyMatcher::FuzzyMatcher(const QByteArray &pattern)
+{
+  m_pattern.reserve(pattern.size());
+  for ( char c : pattern )
+    m_pattern.append( foldCase(c) );
+}
+
+QByteArray FuzzyMatcher::pattern() const
+{
+  return m_pattern;
+}
+
+bool FuzzyMatcher::matches(const char *str, int length) const
+{
+  int position = 0;
+  for ( char c : m_pattern ) {
+    position = findFolded(str, position, length, c);
+    if ( position >= length )
+      return false;
+    position++;
+  }
+  return true;
+}
+
+bool FuzzyMatcher::matches(const QByteArray &str) const
+{
+  return matches(str.constData(), str.size());
+}
+
+bool FuzzyMatcher::match(const char *str, int length, int &score) const
+{
+  score = 0;
+  if ( m_pattern.isEmpty() )
+    return true;
+  if ( !matches(str, length) )
+    return false;
+  score = scoreAlignment(str, length);
+  return true;
+}
+
+bool FuzzyMatcher::match(const QByteArray &str, int &score) const
+{
+  return match(str.constData(), str.size(), score);
+}
+
+int FuzzyMatcher::scoreAlignment(const char *str, int length) const
+{
+  const int patternLength = m_pattern.size();
+
+  // Bonus for matching each position, independent of the rest of the alignment.
+  QVarLengthArray<int, 256> positionBonus(length);
+  for ( int j = 0; j < length; j++ ) {
+    int bonus = 0;
+    if ( j == 0 )
+      bonus += FUZZY_FIRST_LETTER_BONUS;
+    else {
+      char neighbor = str[j-1];
+      if ( neighbor == '_' || neighbor == ' ' )
+        bonus += FUZZY_SEPARATOR_BONUS;
+    }
+    positionBonus[j] = bonus;
+  }
+
+  // best[j]: best score of the pattern so far with its last character
+  // matched at str[j], or INT_MIN if that isn't possible.
+  QVarLengthArray<int, 512> rows(2 * length);
+  int *best = rows.data();
+  int *next = best + length;
+  for ( int j = 0; j < length; j++ ) {
+    if ( foldCase(str[j]) != m_pattern.at(0) ) {
+      best[j] = INT_MIN;
+      continue;
+    }
+    best[j] = positionBonus[j] + std::max(FUZZY_LEADING_LETTER_PENALTY * j, FUZZY_MAX_LEADING_PENALTY);
+  }
+
+  for ( int i = 1; i < patternLength; i++ ) {
+    // Running maximum of best[0..j-2], for matches that aren't adjacent.
+    int bestBefore = INT_MIN;
+    for ( int j = 0; j < length; j++ ) {
+      if ( j >= 2 )
+        bestBefore = std::max(bestBefore, best[j-2]);
+      if ( foldCase(str[j]) != m_pattern.at(i) || j == 0 ) {
+        next[j] = INT_MIN;
+        continue;
+      }
+      int candidate = bestBefore;
+      if ( best[j-1] != INT_MIN )
+        candidate = std::max(candidate, best[j-1] + FUZZY_SEQUENTIAL_BONUS);
+      next[j] = candidate == INT_MIN ? INT_MIN : candidate + positionBonus[j];
+    }
+    std::swap(best, next);
+  }
+
+  int alignment = *std::max_element(best, best + length);
+  return 100 + alignment + FUZZY_UNMATCHED_LETTER_PENALTY * (length - patternLength);
+}
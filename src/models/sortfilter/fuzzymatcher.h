@@ -0,0 +1,41 @@
+/*
+ * FuzzyMatcher
+ * Matches a search pattern against titles the same way fts::fuzzy_match
+ * does: every pattern character has to appear in the title in order,
+ * ignoring ASCII case, and the score rewards matches that are adjacent,
+ * start a word or are at the start of the title. Unlike fts::fuzzy_match
+ * there is no camel case bonus, since titles arrive case folded.
+ *
+ * Titles are first checked with a vectorized subsequence scan that rejects
+ * non-matching titles without scoring them. Titles that pass are scored by
+ * a dynamic programming pass that always finds the best alignment, without
+ * the recursion limit and 256 character cap of the original header.
+ */
+
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+#include <QByteArray>
+
+class FuzzyMatcher
+{
+public:
+  explicit FuzzyMatcher(const QByteArray &pattern);
+
+  QByteArray pattern() const;
+
+  // True if the pattern is a subsequence of str, ignoring ASCII case.
+  bool matches(const char *str, int length) const;
+  bool matches(const QByteArray &str) const;
+
+  // Like matches(), and also scores the best alignment if there is a match.
+  // An empty pattern matches everything with a score of 0.
+  bool match(const char *str, int length, int &score) const;
+  bool match(const QByteArray &str, int &score) const;
+
+private:
+  QByteArray m_pattern; // ASCII lower case
+
+  int scoreAlignment(const char *str, int length) const;
+};
+
+#endif // FUZZYMATCHER_H
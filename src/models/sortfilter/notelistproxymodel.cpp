@@ -2,24 +2,28 @@
 #include "../../meta/db/notedatabase.h"
 #include "../notelistmodel.h"
 #include <QStandardItemModel>
-
-#define FTS_FUZZY_MATCH_IMPLEMENTATION
-#include <fts_fuzzy_match.hpp>
 #include <helper-io.hpp>
 #include <QDebug>
 
 NoteListProxyModel::NoteListProxyModel(QListView *view, Database *db) :
   QSortFilterProxyModel(),
   m_view(view),
-  m_db(db)
+  m_db(db),
+  m_titleMatcher(QByteArray())
 {
   setDynamicSortFilter(true);
 
-  m_delegate = new NoteItemDelegate(m_view, this);
+  m_delegate = new NoteItemDelegate(m_view, this, m_db->noteDatabase());
   m_view->setItemDelegate(m_delegate);
 
+  m_searchEngine = new NoteSearchEngine(this);
+
   connect(m_db->noteDatabase(), &NoteDatabase::noteChanged,
           this, &NoteListProxyModel::noteChanged);
+  connect(m_searchEngine, &NoteSearchEngine::finished,
+          this, &NoteListProxyModel::applyTitleResults);
+  connect(m_db->noteDatabase(), &NoteDatabase::bodySearchFinished,
+          this, &NoteListProxyModel::applyBodyResults);
 }
 
 QVariant NoteListProxyModel::data(const QModelIndex &index, int role) const
@@ -52,10 +56,11 @@ bool NoteListProxyModel::filterAcceptsRow(int sourceRow,
 
   QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
   NoteListItem *item = static_cast<NoteListItem*>(index.internalPointer());
-  Note *note = item->note();
-
-  QUuid curNotebookSyncHash = note->notebook();
-  QVector<QUuid> tagSyncHashes = note->tags();
+  const NoteStore &store = m_db->noteDatabase()->store();
+  NoteStore::Row row = item->storeRow();
+  // Notes that aren't in the database have no fields to filter on.
+  if ( row == NOTE_STORE_NO_ROW )
+    return false;
 
   bool passed_favorite_check = false;
   bool passed_trashed_check  = false;
@@ -69,9 +74,9 @@ bool NoteListProxyModel::filterAcceptsRow(int sourceRow,
   if ( m_favorites_filter == FavoritesFilterDisabled )
     passed_favorite_check = true;
   else if ( m_favorites_filter == FavoritesOnly )
-    passed_favorite_check = note->favorited() ? true : false;
+    passed_favorite_check = store.favorited(row) ? true : false;
   else if ( m_favorites_filter == FavoritesExclude )
-    passed_favorite_check = note->favorited() ? false : true;
+    passed_favorite_check = store.favorited(row) ? false : true;
   if ( !passed_favorite_check )
     return false;
 
@@ -81,9 +86,9 @@ bool NoteListProxyModel::filterAcceptsRow(int sourceRow,
   if ( m_trashed_filter == TrashBoth )
     passed_trashed_check = true;
   else if ( m_trashed_filter == TrashHidden )
-    passed_trashed_check = note->trashed() ? false : true;
+    passed_trashed_check = store.trashed(row) ? false : true;
   else if ( m_trashed_filter == TrashOnly )
-    passed_trashed_check = note->trashed() ? true : false;
+    passed_trashed_check = store.trashed(row) ? true : false;
   if ( !passed_trashed_check )
     return false;
 
@@ -96,26 +101,22 @@ bool NoteListProxyModel::filterAcceptsRow(int sourceRow,
   if ( m_tag_filter.length() == 0 )
     passed_tag_check = true;
 
-  for ( Notebook *n : m_notebook_filter ) {
-    // If notebook is not in notebookDatabase (probably deleted), skip this index.
-    if (!m_db->notebookDatabase()->listRecursively().contains(n))
-      continue;
-    QVector<Notebook*> childNotebooks = n->recurseChildren();
-    QVector<QUuid> notebookSyncHasehs = {n->syncHash()};
-    for (Notebook *child : childNotebooks)
-      notebookSyncHasehs.append( child->syncHash() );
-    if ( notebookSyncHasehs.contains(curNotebookSyncHash) )
+  // Filtered notebooks are matched by id, so one that has been deleted
+  // contains nothing, even if a new notebook now lives at its address.
+  for ( SyncHashInterner::Id n : m_notebook_filter_ids )
+    if ( m_db->notebookDatabase()->notebookContains(n, store.notebook(row)) )
       passed_notebook_check = true;
-  }
   if ( !passed_notebook_check )
     return false;
 
   //////////////////
   /// TAG FILTER ///
   //////////////////
-  for ( Tag *t : m_tag_filter )
-    if ( tagSyncHashes.contains(t->syncHash()) )
+  for ( Tag *t : m_tag_filter ) {
+    NoteStore::Id tag = syncHashInterner()->id(t->syncHash());
+    if ( tag != 0 && store.hasTag(row, tag) )
       passed_tag_check = true;
+  }
 
   if ( !passed_tag_check )
     return false;
@@ -123,13 +124,8 @@ bool NoteListProxyModel::filterAcceptsRow(int sourceRow,
   /////////////////////
   /// Search FILTER ///
   /////////////////////
-  if (m_search_filter == SearchOn) {
-    char *query = HelperIO::QString2CString(m_searchQuery);
-    char *title = HelperIO::QString2CString(note->title());
-    passed_search_check = fts::fuzzy_match_simple(query, title);
-    delete query;
-    delete title;
-  }
+  if (m_search_filter == SearchOn)
+    passed_search_check = searchScore(item->note()).matched;
   else
     passed_search_check = true;
   if (!passed_search_check)
@@ -143,10 +139,20 @@ void NoteListProxyModel::clearFilter(bool invalidate)
   m_favorites_filter = FavoritesFilterDisabled;
   m_trashed_filter = TrashHidden;
   m_notebook_filter.clear();
+  m_notebook_filter_ids.clear();
   m_tag_filter.clear();
   m_filter_out_everything = false;
   m_search_filter = SearchOff;
   m_searchQuery = "";
+  m_searchEngine->cancel();
+  m_scoredQuery.clear();
+  m_titleMatcher = FuzzyMatcher(QByteArray());
+  m_searchScores.clear();
+  m_titleResultsPending = false;
+  m_bodyResultsPending = false;
+  m_titleResults.clear();
+  m_bodyResults = NoteBodySearch();
+  m_pendingMisses.clear();
   if ( invalidate )
     invalidateFilter();
 }
@@ -176,6 +182,7 @@ void NoteListProxyModel::filterOutEverything(bool shouldFilterOutEverything)
 void NoteListProxyModel::addNotebookToFilter(Notebook *notebook)
 {
   m_notebook_filter.append(notebook);
+  m_notebook_filter_ids.append( syncHashInterner()->intern(notebook->syncHash()) );
   invalidateFilter();
 }
 
@@ -196,12 +203,111 @@ void NoteListProxyModel::setTrashedFilter(int trashedFilter) {
 }
 
 void NoteListProxyModel::setSearchQuery(QString searchQuery, int searchFilterMode) {
+  bool wasSearching = m_search_filter == SearchOn;
+
   m_searchQuery = searchQuery;
   m_search_filter = searchFilterMode;
-  //invalidateFilter();
+  m_searchEngine->cancel();
+  m_titleResults.clear();
+  m_bodyResults = NoteBodySearch();
+  m_pendingMisses.clear();
+
+  if ( m_search_filter != SearchOn ) {
+    m_titleResultsPending = false;
+    m_bodyResultsPending = false;
+    m_scoredQuery = m_searchQuery;
+    m_titleMatcher = FuzzyMatcher( HelperIO::searchKey(m_searchQuery) );
+    m_searchScores.clear();
+    invalidate();
+    return;
+  }
+
+  // When the new query extends the last one that was applied, it can only
+  // match a subset of what that one matched. Only those notes are searched.
+  bool refining = wasSearching && refinesQuery(m_scoredQuery, m_searchQuery);
+
+  QVector<NoteSearchEngine::Candidate> candidates;
+  QVector<QUuid> previousMatches;
+  for ( Note *note : m_db->noteDatabase()->list() ) {
+    auto previous = m_searchScores.constFind(note->syncHash());
+    if ( refining && previous != m_searchScores.constEnd() && !previous.value().matched )
+      m_pendingMisses.append(note->syncHash());
+    else {
+      candidates.append({note->syncHash(), note->searchKey()});
+      previousMatches.append(note->syncHash());
+    }
+  }
+
+  // Either half may report back before these calls return. The current
+  // results stay on screen until both are in.
+  m_titleResultsPending = true;
+  m_bodyResultsPending = true;
+  m_searchEngine->search(m_searchQuery, candidates);
+  if ( refining )
+    m_db->noteDatabase()->postBodySearch(m_searchQuery, previousMatches);
+  else
+    m_db->noteDatabase()->postBodySearch(m_searchQuery);
+}
+
+void NoteListProxyModel::applyTitleResults(QString query, QVector<NoteSearchEngine::Result> results)
+{
+  if ( query != m_searchQuery || m_search_filter != SearchOn || !m_titleResultsPending )
+    return;
+  m_titleResults = results;
+  m_titleResultsPending = false;
+  applyPendingSearch();
+}
+
+void NoteListProxyModel::applyBodyResults(QString query, NoteBodySearch results)
+{
+  if ( query != m_searchQuery || m_search_filter != SearchOn || !m_bodyResultsPending )
+    return;
+  m_bodyResults = results;
+  m_bodyResultsPending = false;
+  applyPendingSearch();
+}
+
+void NoteListProxyModel::applyPendingSearch()
+{
+  if ( m_titleResultsPending || m_bodyResultsPending )
+    return;
+
+  m_scoredQuery = m_searchQuery;
+  m_titleMatcher = FuzzyMatcher( HelperIO::searchKey(m_searchQuery) );
+  m_searchScores.clear();
+  m_searchScores.reserve(m_titleResults.size() + m_pendingMisses.size());
+  for ( QUuid syncHash : m_pendingMisses )
+    m_searchScores.insert(syncHash, {false, NotMatched, 0});
+  for ( const NoteSearchEngine::Result &result : m_titleResults )
+    m_searchScores.insert(result.syncHash, {result.matched, result.matched ? MatchedTitle : NotMatched, result.score});
+
+  // Notes matched by their title keep that score.
+  const QVector<NoteSearchResult> &ranked = m_bodyResults.ranked;
+  for ( int i=0; i<ranked.length(); i++ ) {
+    SearchScore &score = m_searchScores[ranked[i].syncHash];
+    if ( !score.matched )
+      score = {true, MatchedBody, ranked.length() - i};
+  }
+  for ( QUuid syncHash : m_bodyResults.containing ) {
+    SearchScore &score = m_searchScores[syncHash];
+    if ( !score.matched )
+      score = {true, MatchedMidWord, 0};
+  }
+
+  m_titleResults.clear();
+  m_bodyResults = NoteBodySearch();
+  m_pendingMisses.clear();
   invalidate();
 }
 
+bool NoteListProxyModel::refinesQuery(const QString &previousQuery, const QString &query)
+{
+  // Typing anywhere would narrow down the fuzzy title matches, but body
+  // matches are word prefixes and verbatim text, which only narrow down
+  // when typing at the end.
+  return !previousQuery.isEmpty() && query.startsWith(previousQuery, Qt::CaseInsensitive);
+}
+
 bool NoteListProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
   if ( !left.isValid() ) return true;
@@ -210,34 +316,38 @@ bool NoteListProxyModel::lessThan(const QModelIndex &left, const QModelIndex &ri
   NoteListItem *item2 = static_cast<NoteListItem*>(right.internalPointer());
 
   if ( m_search_filter == SearchOn ) {
-    int item1_score = 0;
-    int item2_score = 0;
-
-    char *query = HelperIO::QString2CString(m_searchQuery);
-    char *item1_title = HelperIO::QString2CString(item1->note()->title());
-    char *item2_title = HelperIO::QString2CString(item2->note()->title());
-
-    // Get the ranking score of item1 & item2 and store them in *_score variables.
-    fts::fuzzy_match(query, item1_title, item1_score);
-    fts::fuzzy_match(query, item2_title, item2_score);
-
-    delete query;
-    delete item1_title;
-    delete item2_title;
-
-    return item1_score < item2_score;
+    SearchScore score1 = searchScore(item1->note());
+    SearchScore score2 = searchScore(item2->note());
+    if ( score1.tier != score2.tier )
+      return score1.tier < score2.tier;
+    return score1.score < score2.score;
   }
 
+  const NoteStore &store = m_db->noteDatabase()->store();
   switch (m_sortingMethod) {
   case DateCreated:
-    return Note::byDateCreatedAsc(item1->note(), item2->note());
+    return store.dateCreated(item1->storeRow()) < store.dateCreated(item2->storeRow());
   case DateModified:
-    return Note::byDateModifiedAsc(item1->note(), item2->note());
+    return store.dateModified(item1->storeRow()) < store.dateModified(item2->storeRow());
   }
 
   return false;
 }
 
+NoteListProxyModel::SearchScore NoteListProxyModel::searchScore(Note *note) const
+{
+  auto it = m_searchScores.constFind(note->syncHash());
+  if ( it != m_searchScores.constEnd() )
+    return it.value();
+
+  SearchScore score = {false, NotMatched, 0};
+  score.matched = m_titleMatcher.match(note->searchKey(), score.score);
+  if ( score.matched )
+    score.tier = MatchedTitle;
+  m_searchScores.insert(note->syncHash(), score);
+  return score;
+}
+
 NoteListItem *NoteListProxyModel::item(int row)
 {
   QModelIndex i = index(row,0);
@@ -247,17 +357,11 @@ NoteListItem *NoteListProxyModel::item(int row)
 }
 
 void NoteListProxyModel::noteChanged(Note* note) {
-  QModelIndex theIndex = QModelIndex();
-
-  for (int i=0; i<rowCount(); i++) {
-    QModelIndex curIndex = index(i, 0);
-    QModelIndex realCurIndex = mapToSource(curIndex);
-    NoteListItem *item = static_cast<NoteListItem*>( realCurIndex.internalPointer() );
-    if (item->note() == note)
-      theIndex = curIndex;
-  }
-
-  // if (theIndex.isValid())
-  //   m_view->viewport()->repaint();
-  emit dataChanged(theIndex, theIndex);
+  // The title might have changed, so score it again next time. Body
+  // matches can't be checked here, they are kept until the next search.
+  // Repainting is left to NoteListModel, whose dataChanged for the note's
+  // row is mapped onto this model by QSortFilterProxyModel.
+  auto it = m_searchScores.find(note->syncHash());
+  if ( it != m_searchScores.end() && (it.value().tier == NotMatched || it.value().tier == MatchedTitle) )
+    m_searchScores.erase(it);
 }
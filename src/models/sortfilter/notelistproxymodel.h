@@ -9,9 +9,12 @@
 #include <QSortFilterProxyModel>
 #include <QListView>
 #include <QVector>
+#include <QHash>
 #include "../items/notelistitem.h"
 #include "../../meta/db/database.h"
 #include "../delegates/noteitemdelegate.h"
+#include "notesearchengine.h"
+#include "fuzzymatcher.h"
 
 class NoteListProxyModel : public QSortFilterProxyModel
 {
@@ -54,6 +57,8 @@ public:
 
 private slots:
   void noteChanged(Note *note);
+  void applyTitleResults(QString query, QVector<NoteSearchEngine::Result> results);
+  void applyBodyResults(QString query, NoteBodySearch results);
 
 signals:
   void invalidatedFilter();
@@ -69,6 +74,7 @@ private:
 
   bool m_filter_out_everything=false;
   QVector<Notebook*> m_notebook_filter;
+  QVector<SyncHashInterner::Id> m_notebook_filter_ids;
   QVector<Tag*> m_tag_filter;
   int m_favorites_filter=FavoritesFilterDisabled;
   int m_trashed_filter=TrashHidden;
@@ -77,6 +83,36 @@ private:
   int m_search_filter=SearchOff;
   QString m_searchQuery;
 
+  // Every note is scored once per query and looked up from here by the
+  // filter and by lessThan. Titles are fuzzy matched by the search engine,
+  // in the background on big libraries, while note bodies are searched on
+  // the storage thread. (see NoteDatabase::postBodySearch) The table is
+  // replaced in one go once both are in. Notes added afterwards have their
+  // title scored on demand.
+  // Title matches come first, then full-text body matches, then notes
+  // whose body contains the query in the middle of a word.
+  enum SearchTiers {NotMatched, MatchedMidWord, MatchedBody, MatchedTitle};
+  struct SearchScore {
+    bool matched;
+    int tier;
+    int score; // Higher is better, within a tier
+  };
+  NoteSearchEngine *m_searchEngine;
+  QString m_scoredQuery; // The query m_searchScores belongs to
+  FuzzyMatcher m_titleMatcher; // Scores titles against m_scoredQuery
+  mutable QHash<QUuid, SearchScore> m_searchScores;
+  // Both halves of the search in progress
+  bool m_titleResultsPending=false;
+  bool m_bodyResultsPending=false;
+  QVector<NoteSearchEngine::Result> m_titleResults;
+  NoteBodySearch m_bodyResults;
+  // Notes known not to match the search in progress. (see refinesQuery)
+  QVector<QUuid> m_pendingMisses;
+
+  void applyPendingSearch();
+  SearchScore searchScore(Note *note) const;
+  static bool refinesQuery(const QString &previousQuery, const QString &query);
+
 };
 
 #endif // NOTELISTPROXYMODEL_H
@@ -0,0 +1,110 @@
+#include "notesearchengine.h"
+#include "fuzzymatcher.h"
+#include <QtConcurrent>
+#include <QSharedPointer>
+#include <helper-io.hpp>
+#include <algorithm>
+
+namespace {
+
+// Scores one range of the candidates. The candidates are shared between
+// all chunks instead of being copied into each one.
+struct ScoreChunk {
+  typedef QVector<NoteSearchEngine::Result> result_type;
+
+  QByteArray query;
+  QSharedPointer<const QVector<NoteSearchEngine::Candidate>> candidates;
+
+  result_type operator()(const QPair<int,int> &range) const {
+    return NoteSearchEngine::score(query, *candidates, range.first, range.second);
+  }
+};
+
+void mergeChunk(QVector<NoteSearchEngine::Result> &results, const QVector<NoteSearchEngine::Result> &chunk)
+{
+  results += chunk;
+}
+
+}
+
+NoteSearchEngine::NoteSearchEngine(QObject *parent) :
+  QObject(parent)
+{
+  qRegisterMetaType<QVector<NoteSearchEngine::Result>>();
+  connect(&m_watcher, &QFutureWatcher<QVector<Result>>::finished,
+          this, &NoteSearchEngine::handleFinished);
+}
+
+NoteSearchEngine::~NoteSearchEngine()
+{
+  cancel();
+  m_watcher.waitForFinished();
+}
+
+void NoteSearchEngine::search(QString query, QVector<Candidate> candidates)
+{
+  cancel();
+  m_query = query;
+  QByteArray queryKey = HelperIO::searchKey(query);
+
+  if ( candidates.size() < NOTE_SEARCH_PARALLEL_THRESHOLD ) {
+    publish(query, score(queryKey, candidates, 0, candidates.size()));
+    return;
+  }
+
+  QVector<QPair<int,int>> chunks;
+  for (int i = 0; i < candidates.size(); i += NOTE_SEARCH_CHUNK_SIZE)
+    chunks.append( qMakePair(i, qMin(i + NOTE_SEARCH_CHUNK_SIZE, candidates.size())) );
+
+  ScoreChunk scoreChunk;
+  scoreChunk.query = queryKey;
+  scoreChunk.candidates = QSharedPointer<const QVector<Candidate>>::create(candidates);
+  m_watcher.setFuture( QtConcurrent::mappedReduced(chunks, scoreChunk, mergeChunk,
+                                                   QtConcurrent::UnorderedReduce) );
+}
+
+void NoteSearchEngine::cancel()
+{
+  // Chunks that already started run to completion, but their results
+  // are never published.
+  if ( m_watcher.isRunning() )
+    m_watcher.cancel();
+}
+
+bool NoteSearchEngine::isRunning() const
+{
+  return m_watcher.isRunning();
+}
+
+QVector<NoteSearchEngine::Result> NoteSearchEngine::score(const QByteArray &query,
+                                                          const QVector<Candidate> &candidates,
+                                                          int begin, int end)
+{
+  FuzzyMatcher matcher(query);
+  QVector<Result> results;
+  results.reserve(end - begin);
+  for (int i = begin; i < end; i++) {
+    Result result;
+    result.syncHash = candidates.at(i).syncHash;
+    result.matched = matcher.match(candidates.at(i).title, result.score);
+    results.append(result);
+  }
+  return results;
+}
+
+void NoteSearchEngine::handleFinished()
+{
+  if ( m_watcher.isCanceled() )
+    return;
+  publish(m_query, m_watcher.result());
+}
+
+void NoteSearchEngine::publish(QString query, QVector<Result> results)
+{
+  std::stable_sort(results.begin(), results.end(), [](const Result &a, const Result &b) {
+    if ( a.matched != b.matched )
+      return a.matched;
+    return a.score > b.score;
+  });
+  emit finished(query, results);
+}
@@ -0,0 +1,67 @@
+/*
+ * NoteSearchEngine
+ * Fuzzy matches note titles against a search query. Large searches are
+ * split into chunks and scored on the global thread pool, so typing stays
+ * responsive on big libraries. Starting a new search cancels the one
+ * still running, and only the latest search reports its results.
+ */
+
+#ifndef NOTESEARCHENGINE_H
+#define NOTESEARCHENGINE_H
+#include <QObject>
+#include <QFutureWatcher>
+#include <QByteArray>
+#include <QVector>
+#include <QUuid>
+
+// Searches with fewer candidates than this are scored right away on the
+// calling thread, where starting threads would cost more than it saves.
+#define NOTE_SEARCH_PARALLEL_THRESHOLD 4096
+#define NOTE_SEARCH_CHUNK_SIZE         1024
+
+class NoteSearchEngine : public QObject
+{
+  Q_OBJECT
+public:
+  // Snapshot of a note, taken on the GUI thread before scoring starts.
+  struct Candidate {
+    QUuid syncHash;
+    QByteArray title; // Note::searchKey()
+  };
+  struct Result {
+    QUuid syncHash;
+    bool matched;
+    int score;
+  };
+
+  explicit NoteSearchEngine(QObject *parent = nullptr);
+  ~NoteSearchEngine();
+
+  // Scores every candidate against query, which is folded the same way as
+  // the candidates' titles. The results, best match first,
+  // are delivered by finished(), which is emitted before this returns for
+  // small searches.
+  void search(QString query, QVector<Candidate> candidates);
+  void cancel();
+  bool isRunning() const;
+
+  // Scores a range of candidates against an already folded query.
+  static QVector<Result> score(const QByteArray &query, const QVector<Candidate> &candidates,
+                               int begin, int end);
+
+signals:
+  void finished(QString query, QVector<NoteSearchEngine::Result> results);
+
+private slots:
+  void handleFinished();
+
+private:
+  QString m_query;
+  QFutureWatcher<QVector<Result>> m_watcher;
+
+  void publish(QString query, QVector<Result> results);
+};
+
+Q_DECLARE_METATYPE(QVector<NoteSearchEngine::Result>)
+
+#endif // NOTESEARCHENGINE_H
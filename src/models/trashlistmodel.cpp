@@ -0,0 +1,177 @@
+#include "trashlistmodel.h"
+#include <algorithm>
+#include <functional>
+
+TrashListModel::TrashListModel(NoteDatabase *noteDatabase, QObject *parent) :
+  QAbstractListModel(parent),
+  m_noteDatabase(noteDatabase)
+{
+  connect(m_noteDatabase, &NoteDatabase::noteTrashedOrRestored,
+          this, &TrashListModel::noteTrashedOrRestored);
+  connect(m_noteDatabase, &NoteDatabase::noteAboutToBeDeleted,
+          this, &TrashListModel::noteAboutToBeDeleted);
+  connect(m_noteDatabase, &NoteDatabase::notesAboutToBeDeleted,
+          this, &TrashListModel::notesAboutToBeDeleted);
+  connect(m_noteDatabase, &NoteDatabase::noteChanged,
+          this, &TrashListModel::noteChanged);
+  reload();
+}
+
+int TrashListModel::rowCount(const QModelIndex &parent) const
+{
+  if ( parent.isValid() )
+    return 0;
+  return m_entries.size();
+}
+
+QVariant TrashListModel::data(const QModelIndex &index, int role) const
+{
+  Note *note = noteFromIndex(index);
+  if ( note == nullptr )
+    return QVariant();
+
+  if ( role == Qt::DisplayRole || role == Qt::ToolTipRole )
+    return note->title();
+
+  return QVariant();
+}
+
+Note *TrashListModel::noteFromIndex(const QModelIndex &index) const
+{
+  if ( !index.isValid() || index.row() >= m_entries.size() )
+    return nullptr;
+  return m_entries.at(index.row()).note;
+}
+
+QModelIndex TrashListModel::indexOfNote(Note *note) const
+{
+  int row = rowOfNote(note);
+  return row >= 0 ? index(row) : QModelIndex();
+}
+
+QVector<Note*> TrashListModel::notesInSelection(const QItemSelection &selection) const
+{
+  QVector<int> rows;
+  for (const QItemSelectionRange &range : selection)
+    for (int row = range.top(); row <= range.bottom(); row++)
+      rows.append(row);
+  std::sort(rows.begin(), rows.end());
+
+  QVector<Note*> notes;
+  notes.reserve(rows.size());
+  for (int row : rows)
+    notes.append(m_entries.at(row).note);
+  return notes;
+}
+
+void TrashListModel::reload()
+{
+  beginResetModel();
+
+  m_entries.clear();
+  m_sortKeys.clear();
+  QSet<Note*> trashed = m_noteDatabase->trashedNotes();
+  m_entries.reserve(trashed.size());
+  for (Note *note : trashed) {
+    qint64 sortKey = note->dateCreated().toMSecsSinceEpoch();
+    m_entries.append({sortKey, note});
+    m_sortKeys.insert(note, sortKey);
+  }
+  std::sort(m_entries.begin(), m_entries.end(), entryLessThan);
+
+  endResetModel();
+}
+
+void TrashListModel::noteTrashedOrRestored(Note *note, bool trashed)
+{
+  if ( trashed ) {
+    if ( m_sortKeys.contains(note) )
+      return;
+    Entry entry = {note->dateCreated().toMSecsSinceEpoch(), note};
+    int row = std::lower_bound(m_entries.begin(), m_entries.end(), entry, entryLessThan) - m_entries.begin();
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries.insert(row, entry);
+    m_sortKeys.insert(note, entry.sortKey);
+    endInsertRows();
+  }
+  else
+    noteAboutToBeDeleted(note);
+}
+
+void TrashListModel::noteAboutToBeDeleted(Note *note)
+{
+  int row = rowOfNote(note);
+  if ( row < 0 )
+    return;
+  beginRemoveRows(QModelIndex(), row, row);
+  m_entries.remove(row);
+  m_sortKeys.remove(note);
+  endRemoveRows();
+}
+
+void TrashListModel::notesAboutToBeDeleted(QVector<Note*> notes)
+{
+  QVector<int> rows;
+  for (Note *note : notes) {
+    int row = rowOfNote(note);
+    if ( row >= 0 )
+      rows.append(row);
+  }
+  if ( rows.isEmpty() )
+    return;
+  std::sort(rows.begin(), rows.end());
+
+  // Emptying the trash is a single range. Anything more scattered is
+  // dropped in one pass behind a reset, rather than a row at a time.
+  bool contiguous = rows.last() - rows.first() + 1 == rows.size();
+  if ( contiguous ) {
+    beginRemoveRows(QModelIndex(), rows.first(), rows.last());
+    m_entries.remove(rows.first(), rows.size());
+  }
+  else {
+    beginResetModel();
+    int next = 0;
+    int kept = 0;
+    for (int row = 0; row < m_entries.size(); row++) {
+      if ( next < rows.size() && rows.at(next) == row )
+        next++;
+      else
+        m_entries[kept++] = m_entries.at(row);
+    }
+    m_entries.resize(kept);
+  }
+  for (Note *note : notes)
+    m_sortKeys.remove(note);
+
+  if ( contiguous )
+    endRemoveRows();
+  else
+    endResetModel();
+}
+
+void TrashListModel::noteChanged(Note *note)
+{
+  int row = rowOfNote(note);
+  if ( row >= 0 )
+    emit dataChanged(index(row), index(row));
+}
+
+// Newest first, ties broken by address so that every entry has one place.
+bool TrashListModel::entryLessThan(const Entry &a, const Entry &b)
+{
+  if ( a.sortKey != b.sortKey )
+    return a.sortKey > b.sortKey;
+  return std::less<Note*>()(a.note, b.note);
+}
+
+int TrashListModel::rowOfNote(Note *note) const
+{
+  auto key = m_sortKeys.find(note);
+  if ( key == m_sortKeys.end() )
+    return -1;
+  Entry entry = {key.value(), note};
+  auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry, entryLessThan);
+  if ( it == m_entries.end() || it->note != note )
+    return -1;
+  return it - m_entries.begin();
+}
@@ -0,0 +1,55 @@
+/*
+ * TrashListModel
+ * The notes in the trash, newest first. It follows the note database as
+ * notes are trashed, restored or deleted, so it is only filled once.
+ */
+
+#ifndef TRASHLISTMODEL_H
+#define TRASHLISTMODEL_H
+#include <QAbstractListModel>
+#include <QItemSelection>
+#include <QHash>
+#include <QVector>
+#include "../meta/db/notedatabase.h"
+
+class TrashListModel : public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  explicit TrashListModel(NoteDatabase *noteDatabase, QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role) const override;
+
+  Note *noteFromIndex(const QModelIndex &index) const;
+  QModelIndex indexOfNote(Note *note) const;
+
+  // Notes in the selected ranges, top to bottom.
+  QVector<Note*> notesInSelection(const QItemSelection &selection) const;
+
+  // Fills the model again from the note database's trashed notes.
+  void reload();
+
+private slots:
+  void noteTrashedOrRestored(Note *note, bool trashed);
+  void noteAboutToBeDeleted(Note *note);
+  void notesAboutToBeDeleted(QVector<Note*> notes);
+  void noteChanged(Note *note);
+
+private:
+  NoteDatabase *m_noteDatabase;
+
+  // Rows are kept sorted by the note's creation date at the time it was
+  // added, so a note's row can be found with a binary search.
+  struct Entry {
+    qint64 sortKey;
+    Note *note;
+  };
+  QVector<Entry> m_entries;
+  QHash<Note*, qint64> m_sortKeys;
+
+  static bool entryLessThan(const Entry &a, const Entry &b);
+  int rowOfNote(Note *note) const;
+};
+
+#endif // TRASHLISTMODEL_H
@@ -0,0 +1,99 @@
+#include "notesavequeue.h"
+#include <QDebug>
+
+NoteSaveQueue::NoteSaveQueue(SQLManager *sqlManager, QObject *parent) :
+  QObject(parent),
+  m_sqlManager(sqlManager)
+{
+  m_idleTimer.setSingleShot(true);
+  m_idleTimer.setInterval(NOTE_SAVE_QUEUE_IDLE_MSECS);
+  m_maxDelayTimer.setSingleShot(true);
+  m_maxDelayTimer.setInterval(NOTE_SAVE_QUEUE_MAX_DELAY_MSECS);
+
+  connect(&m_idleTimer, &QTimer::timeout,
+          this, static_cast<void (NoteSaveQueue::*)()>(&NoteSaveQueue::flush));
+  connect(&m_maxDelayTimer, &QTimer::timeout,
+          this, static_cast<void (NoteSaveQueue::*)()>(&NoteSaveQueue::flush));
+}
+
+NoteSaveQueue::~NoteSaveQueue()
+{
+  flush();
+}
+
+void NoteSaveQueue::enqueue(Note *note)
+{
+  if ( m_pending.contains(note) )
+    m_coalescedCount++;
+  else
+    m_pending.append(note);
+
+  // Restart the idle timer on every change. The max delay timer makes sure
+  // notes still get saved while the user is typing non-stop.
+  m_idleTimer.start();
+  if ( !m_maxDelayTimer.isActive() )
+    m_maxDelayTimer.start();
+}
+
+void NoteSaveQueue::remove(Note *note)
+{
+  m_pending.removeAll(note);
+}
+
+bool NoteSaveQueue::isPending(Note *note) const
+{
+  return m_pending.contains(note);
+}
+
+int NoteSaveQueue::pendingCount() const
+{
+  return m_pending.size();
+}
+
+int NoteSaveQueue::writeCount() const
+{
+  return m_writeCount;
+}
+
+int NoteSaveQueue::coalescedCount() const
+{
+  return m_coalescedCount;
+}
+
+void NoteSaveQueue::flush()
+{
+  m_idleTimer.stop();
+  m_maxDelayTimer.stop();
+
+  if ( m_pending.isEmpty() )
+    return;
+
+  // Take the list first so that changes made while saving are queued again.
+  QVector<Note*> notes = m_pending;
+  m_pending.clear();
+
+  int written = 0;
+  for (Note *note : notes)
+    if ( save(note) )
+      written++;
+
+  emit flushed(written);
+}
+
+void NoteSaveQueue::flush(Note *note)
+{
+  if ( !m_pending.contains(note) )
+    return;
+  m_pending.removeAll(note);
+  if ( save(note) )
+    emit flushed(1);
+}
+
+bool NoteSaveQueue::save(Note *note)
+{
+  // The SQL manager writes each note in its own transaction so the note
+  // row and its tags are always saved together.
+  m_sqlManager->postUpdateNote(note);
+  m_writeCount++;
+  return true;
+}
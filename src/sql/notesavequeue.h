@@ -0,0 +1,61 @@
+/*
+ * NoteSaveQueue
+ * Collects changed notes and writes them to SQL in batches instead of
+ * once per change. Repeated changes to the same note before a flush are
+ * merged into a single write.
+ *
+ * The queue flushes itself once the user has been idle for a moment, or
+ * after a maximum delay if changes keep coming in. It can also be flushed
+ * by hand, ex. when switching notes or shutting down.
+ */
+
+#ifndef NOTESAVEQUEUE_H
+#define NOTESAVEQUEUE_H
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include "sqlmanager.h"
+#include "../meta/note.h"
+
+#define NOTE_SAVE_QUEUE_IDLE_MSECS      1000
+#define NOTE_SAVE_QUEUE_MAX_DELAY_MSECS 5000
+
+class NoteSaveQueue : public QObject
+{
+  Q_OBJECT
+public:
+  explicit NoteSaveQueue(SQLManager *sqlManager, QObject *parent = nullptr);
+  ~NoteSaveQueue();
+
+  void enqueue(Note *note);
+  // Drops a note from the queue without saving it. (ex. It was deleted)
+  void remove(Note *note);
+
+  bool isPending(Note *note) const;
+  int  pendingCount() const;
+
+  // Statistics
+  int writeCount() const;     // Amount of note writes handed to the SQL manager
+  int coalescedCount() const; // Amount of changes merged into an already queued write
+
+public slots:
+  void flush();
+  void flush(Note *note);
+
+signals:
+  void flushed(int notesWritten);
+
+private:
+  SQLManager *m_sqlManager;
+  QVector<Note*> m_pending;
+
+  QTimer m_idleTimer;
+  QTimer m_maxDelayTimer;
+
+  int m_writeCount=0;
+  int m_coalescedCount=0;
+
+  bool save(Note *note);
+};
+
+#endif // NOTESAVEQUEUE_H
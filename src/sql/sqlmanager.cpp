@@ -4,9 +4,8 @@
 #include <helper-io.hpp>
 #include <QSqlQuery>
 #include <QSqlError>
-#include <QSqlTableModel>
-#include <QSqlRecord>
 #include <QVariant>
+#include <algorithm>
 
 /*
  * Future Note:
@@ -14,30 +13,47 @@
  * classes of the individual object classes.
  */
 
-SQLManager::SQLManager(QObject *parent) : QObject(parent)
+SQLManager::SQLManager(QObject *parent, QString connectionName, bool prepareSchema) : QObject(parent)
 {
   // Determine an appropraite pathname for the sqlite3 database
   QDir data_dir = HelperIO::dataDir();
   m_location = data_dir.filePath("vibrato-db.sqlite3");
 
   // Open the database connection
-  m_sqldb = QSqlDatabase::addDatabase("QSQLITE");
+  m_sqldb = QSqlDatabase::addDatabase("QSQLITE", connectionName);
   m_sqldb.setDatabaseName(m_location);
+  // The GUI and storage thread connections share the same file. Wait on
+  // each other's locks rather than failing.
+  m_sqldb.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
   bool ok = m_sqldb.open();
   if (!ok) qFatal("Fatal error establishing a connection with Vibrato's sqlite3 database. :(");
 
+  // Write-ahead logging lets the GUI thread read while the storage thread writes.
+  realBasicQuery("PRAGMA journal_mode=WAL");
+
+  if ( !prepareSchema )
+    return;
+
   // Check if 'notes' table exists. If not, create it and import tutorial note.
   if ( !m_sqldb.tables().contains("notes") )
     m_shouldImportTutorialNotes = true;
 
-  // Create any tables that are non-existent.
+  // Create any tables that are non-existent and bring older databases
+  // up to date.
   runScript(":sql/create.sql");
+  migrate();
 
   if ( m_shouldImportTutorialNotes )
     importTutorialNotes();
 }
 
+SQLManager::~SQLManager()
+{
+  stopStorageThread();
+}
+
 void SQLManager::close() {
+  clearStatementCache();
   m_sqldb.close();
 }
 
@@ -48,7 +64,7 @@ QString SQLManager::location() const
 
 QSqlQuery SQLManager::basicQuery(QString query)
 {
-  QSqlQuery q;
+  QSqlQuery q(m_sqldb);
 
   bool success = q.exec(query);
   if (!success)
@@ -86,7 +102,7 @@ Map SQLManager::row(QSqlQuery query, QStringList tableLabels) {
 }
 
 Map SQLManager::row(QString queryString, QStringList tableLabels) {
-  QSqlQuery q;
+  QSqlQuery q(m_sqldb);
   q.exec(queryString);
   return row(q, tableLabels);
 }
@@ -115,6 +131,30 @@ MapVector SQLManager::rows(QString query, QStringList tableColumns)
   return rows(q, tableColumns);
 }
 
+bool SQLManager::transaction()
+{
+  bool success = m_sqldb.transaction();
+  if (!success)
+    logSqlError(m_sqldb.lastError());
+  return success;
+}
+
+bool SQLManager::commit()
+{
+  bool success = m_sqldb.commit();
+  if (!success)
+    logSqlError(m_sqldb.lastError());
+  return success;
+}
+
+bool SQLManager::rollback()
+{
+  bool success = m_sqldb.rollback();
+  if (!success)
+    logSqlError(m_sqldb.lastError());
+  return success;
+}
+
 bool SQLManager::runScript(QString fileName)
 {
   QFile file(fileName);
@@ -122,12 +162,15 @@ bool SQLManager::runScript(QString fileName)
     qWarning() << "Unable to load SQL file" << fileName;
     return false;
   }
-  QSqlQuery query;
+  QSqlQuery query(m_sqldb);
   return runScript(&file, &query);
 }
 
 bool SQLManager::runScript(QFile *file, QSqlQuery *query)
 {
+  // Scripts may change the schema the cached statements were prepared against.
+  clearStatementCache();
+
   QString contents = file->readAll();
 
   // Remove sql comments and
@@ -136,17 +179,81 @@ bool SQLManager::runScript(QFile *file, QSqlQuery *query)
   contents = contents.replace(QRegExp("\\n\\n+"), "\n");
 
   QStringList queryList = contents.split(";");
+  bool allSucceeded = true;
+  QString trigger;
 
   for ( QString line : queryList ) {
     line = line.trimmed();
     if ( line.isEmpty() ) continue;
 
+    // Trigger bodies contain semicolons of their own. Keep joining the
+    // pieces until the END of the trigger.
+    if ( !trigger.isEmpty() || line.startsWith("CREATE TRIGGER", Qt::CaseInsensitive) ) {
+      trigger += line + ";\n";
+      if ( !line.contains(QRegExp("\\bEND$", Qt::CaseInsensitive)) )
+        continue;
+      line = trigger;
+      trigger.clear();
+    }
+
     bool success = query->exec(line);
-    if (!success)
+    if (!success) {
       logSqlError(query->lastError());
+      allSucceeded = false;
+    }
   }
 
-  return query->isActive();
+  return allSucceeded && query->isActive();
+}
+
+int SQLManager::schemaVersion()
+{
+  VariantList version = column("PRAGMA user_version");
+  return version.isEmpty() ? 0 : version.first().toInt();
+}
+
+bool SQLManager::migrate()
+{
+  bool migrated = applyMigrations();
+  // notes_fts only comes and goes with migrations, so look for it once here
+  // rather than on every search.
+  m_fullTextSearch = !column("SELECT 1 FROM sqlite_master WHERE name = 'notes_fts'").isEmpty();
+  return migrated;
+}
+
+bool SQLManager::applyMigrations()
+{
+  // Migration scripts are named "<version>-<description>.sql". Each one
+  // brings the database from version-1 up to version.
+  QMap<int, QString> migrations;
+  QDir migrationDir(":/sql/migrations");
+  for ( QString fileName : migrationDir.entryList({"*.sql"}, QDir::Files) )
+    migrations.insert( fileName.section('-', 0, 0).toInt(), migrationDir.filePath(fileName) );
+
+  int version = schemaVersion();
+  for ( int migration : migrations.keys() ) {
+    if ( migration <= version )
+      continue;
+
+    QFile file( migrations.value(migration) );
+    if ( !file.open(QIODevice::ReadOnly) ) {
+      qWarning() << "Unable to load SQL migration" << file.fileName();
+      return false;
+    }
+
+    // Each migration and its version bump are applied together or not at all.
+    transaction();
+    QSqlQuery query(m_sqldb);
+    if ( !runScript(&file, &query) ||
+         !realBasicQuery(QString("PRAGMA user_version = %1").arg(migration)) ) {
+      rollback();
+      qWarning() << "SQL migration" << migration << "failed. The database was left at version" << version;
+      return false;
+    }
+    commit();
+    version = migration;
+  }
+  return true;
 }
 
 bool SQLManager::logSqlError(QSqlError error, bool fatal) {
@@ -168,6 +275,14 @@ bool SQLManager::logSqlError(QSqlError error, bool fatal) {
   return false;
 }
 
+QVariant SQLManager::syncHashValue(QUuid syncHash)
+{
+  // Nil sync hashes (ex. the Default Notebook) are stored as NULL.
+  if ( syncHash.isNull() )
+    return QVariant(QVariant::String);
+  return syncHash.toString(QUuid::WithoutBraces);
+}
+
 QStringList SQLManager::noteColumns() const
 {
   return m_noteColumns;
@@ -182,30 +297,49 @@ QStringList SQLManager::tagColumns() const {
   return m_tagColumns;
 }
 
-QVector<Note*> SQLManager::notes() {
+QVector<Note*> SQLManager::notes(bool metadataOnly) {
   QVector<Note*> notes;
 
-  QString queryString = QString("SELECT %1 FROM notes").arg(noteColumns().join(", "));
-  MapVector rawNotes = rows(queryString, noteColumns());
-
-  for ( int i=0; i<rawNotes.length(); i++ ) {
-    QMap<QString, QVariant> noteObject = rawNotes[i];
-
-    QString sync_hash       = noteObject["sync_hash"].toString();
-    QString title           = noteObject["title"].toString();
-    QString text            = noteObject["text"].toString();
-    QDateTime date_created  = noteObject["date_created"].toDateTime();
-    QDateTime date_modified = noteObject["date_modified"].toDateTime();
-    QString notebook        = noteObject["notebook"].toString();
-    bool favorited          = noteObject["favorited"].toBool();
-    bool encrypted          = noteObject["encrypted"].toBool();
-    bool trashed            = noteObject["trashed"].toBool();
-
-    // Parse a tags array
+  QStringList columns = noteColumns();
+  if ( metadataOnly )
+    columns[ columns.indexOf("text") ] = QString("substr(text, 1, %1)").arg(NOTE_EXCERPT_LENGTH);
+
+  // Notes and their tag links are read with two scans, both sorted by the
+  // note's sync hash, and merged in memory. This keeps the amount of queries
+  // fixed no matter how many notes are in the library.
+  QSqlQuery noteQuery(m_sqldb);
+  QSqlQuery tagQuery(m_sqldb);
+  noteQuery.setForwardOnly(true);
+  tagQuery.setForwardOnly(true);
+
+  noteQuery.exec( QString("SELECT %1 FROM notes ORDER BY sync_hash ASC").arg(columns.join(", ")) );
+  if ( !logSqlError(noteQuery.lastError()) )
+    return notes;
+  tagQuery.exec( "SELECT note, tag FROM notes_tags ORDER BY note ASC" );
+  logSqlError(tagQuery.lastError());
+
+  bool hasTagRow = tagQuery.isActive() && tagQuery.next();
+
+  while ( noteQuery.next() ) {
+    QString sync_hash       = noteQuery.value(0).toString();
+    QString title           = noteQuery.value(1).toString();
+    QString text            = noteQuery.value(2).toString();
+    QDateTime date_created  = noteQuery.value(3).toDateTime();
+    QDateTime date_modified = noteQuery.value(4).toDateTime();
+    QString notebook        = noteQuery.value(5).toString();
+    bool favorited          = noteQuery.value(6).toBool();
+    bool encrypted          = noteQuery.value(7).toBool();
+    bool trashed            = noteQuery.value(8).toBool();
+
+    // Skip over tag links that belong to notes which no longer exist,
+    // then collect the links belonging to this note.
     QVector<QUuid> tags;
-    QString tagVariantsQuery = QString("select tag from notes_tags where note = \"%1\"").arg(sync_hash);
-    for ( QVariant tagVariant : column(tagVariantsQuery) )
-      tags.append( tagVariant.toString() );
+    while ( hasTagRow && tagQuery.value(0).toString() < sync_hash )
+      hasTagRow = tagQuery.next();
+    while ( hasTagRow && tagQuery.value(0).toString() == sync_hash ) {
+      tags.append( tagQuery.value(1).toString() );
+      hasTagRow = tagQuery.next();
+    }
 
     Note *note = new Note(sync_hash,
                           title,
@@ -217,43 +351,103 @@ QVector<Note*> SQLManager::notes() {
                           favorited,
                           encrypted,
                           trashed);
+    if ( metadataOnly )
+      note->unloadText();
     notes.append(note);
-
   }
   return notes;
 }
 
-QVector<Notebook*> SQLManager::notebooks() {
-  return m_getNotebooks();
+QString SQLManager::noteText(QUuid noteSyncHash)
+{
+  QSqlQuery q = preparedQuery("SELECT text FROM notes WHERE sync_hash = :sync_hash");
+  q.bindValue(":sync_hash", noteSyncHash.toString(QUuid::WithoutBraces));
+  q.exec();
+  QString text;
+  if ( logSqlError(q.lastError()) && q.next() )
+    text = q.value(0).toString();
+  q.finish();
+  return text;
 }
 
-QVector<Notebook*> SQLManager::m_getNotebooks(Notebook *parent) {
-  QVector<Notebook*> notebooks;
-  QSqlQuery q;
-
-  QString queryString;
-  if (parent == nullptr)
-    queryString = "SELECT %1 FROM notebooks WHERE parent IS NULL ORDER BY row ASC";
-  else
-    queryString = "SELECT %1 FROM notebooks WHERE parent = :sync_hash ORDER BY row ASC";
+QHash<QUuid, QString> SQLManager::noteTexts(const QVector<QUuid> &noteSyncHashes)
+{
+  QHash<QUuid, QString> texts;
+  texts.reserve(noteSyncHashes.size());
+
+  // One query per batch, keeping well under SQLite's limit on bound values.
+  for ( int first = 0; first < noteSyncHashes.size(); first += NOTE_TEXT_BATCH_SIZE ) {
+    int count = qMin(NOTE_TEXT_BATCH_SIZE, noteSyncHashes.size() - first);
+    QStringList placeholders;
+    for ( int i = 0; i < count; i++ )
+      placeholders.append("?");
+
+    QSqlQuery q(m_sqldb);
+    q.setForwardOnly(true);
+    q.prepare( QString("SELECT sync_hash, text FROM notes WHERE sync_hash IN (%1)").arg(placeholders.join(", ")) );
+    for ( int i = 0; i < count; i++ )
+      q.addBindValue( noteSyncHashes.at(first + i).toString(QUuid::WithoutBraces) );
+    if ( !q.exec() ) {
+      logSqlError(q.lastError());
+      continue;
+    }
+    while ( q.next() )
+      texts.insert( QUuid(q.value(0).toString()), q.value(1).toString() );
+  }
+  return texts;
+}
 
-  queryString = queryString.arg( notebookColumns().join(", ") );
+void SQLManager::forEachNoteText(std::function<void(QUuid, const QString&)> function)
+{
+  QSqlQuery q(m_sqldb);
+  q.setForwardOnly(true);
+  if ( !q.exec("SELECT sync_hash, text FROM notes") ) {
+    logSqlError(q.lastError());
+    return;
+  }
+  while ( q.next() )
+    function( QUuid(q.value(0).toString()), q.value(1).toString() );
+}
 
-  q.prepare(queryString);
-  if (parent != nullptr)
-    q.bindValue(":sync_hash", parent->syncHash().toString(QUuid::WithoutBraces));
-  q.exec();
+QVector<Notebook*> SQLManager::notebooks() {
+  // Fetch the whole forest at once. Sorting by depth puts every parent
+  // before its children, so the tree can be put together in one pass.
+  QSqlQuery q(m_sqldb);
+  q.setForwardOnly(true);
+  q.exec("WITH RECURSIVE tree(sync_hash, title, date_modified, parent, row, encrypted, depth) AS ("
+         "  SELECT sync_hash, title, date_modified, parent, row, encrypted, 0 "
+         "  FROM notebooks WHERE parent IS NULL "
+         "  UNION ALL "
+         "  SELECT n.sync_hash, n.title, n.date_modified, n.parent, n.row, n.encrypted, tree.depth + 1 "
+         "  FROM notebooks n JOIN tree ON n.parent = tree.sync_hash"
+         ") "
+         "SELECT sync_hash, title, date_modified, parent, row, encrypted "
+         "FROM tree ORDER BY depth ASC, row ASC");
+  logSqlError(q.lastError());
   MapVector notebookResults = rows(q, notebookColumns());
 
+  // Make room for the whole tree up front so it is laid out in one chunk.
+  Notebook::reservePool(notebookResults.size());
+
+  QVector<Notebook*> notebooks;
+  QHash<QString, Notebook*> bySyncHash;
+  bySyncHash.reserve(notebookResults.size());
+
   for (Map n : notebookResults) {
-    Notebook *notebook = new Notebook(n["sync_hash"].toString(),
+    QString syncHash = n["sync_hash"].toString();
+    Notebook *parent = n["parent"].isNull() ? nullptr : bySyncHash.value(n["parent"].toString());
+    Notebook *notebook = new Notebook(syncHash,
                                       n["title"].toString(),
                                       n["date_modified"].toDateTime(),
                                       parent,
                                       n["row"].toInt(),
                                       n["encrypted"].toBool());
-    notebook->setChildren(m_getNotebooks(notebook));
-    notebooks.append(notebook);
+    bySyncHash.insert(syncHash, notebook);
+
+    if (parent != nullptr)
+      parent->addChild_primitive(notebook);
+    else
+      notebooks.append(notebook);
   }
 
   return notebooks;
@@ -264,6 +458,7 @@ QVector<Tag*> SQLManager::tags() {
   QString queryString =
     QString("select %1 from tags ORDER BY row ASC").arg( tagColumns().join(", ") );
   MapVector tagResults = rows(queryString, tagColumns());
+  Tag::reservePool(tagResults.size());
 
   for ( Map tagMap : tagResults) {
     Tag *t = new Tag(tagMap["sync_hash"].toString(),
@@ -279,85 +474,88 @@ QVector<Tag*> SQLManager::tags() {
 
 bool SQLManager::addNote(Note *note)
 {
-  QStringList noteCols = noteColumns();
-  QStringList columnPlaceholders;
-
-  for (QString col : noteCols)
-    columnPlaceholders.append( QString(":%1").arg(col) );
-
-  QString queryString = QString("INSERT INTO notes (%1) "
-                                "VALUES (%2)").arg(noteCols.join(", "),
-                                                   columnPlaceholders.join(", "));
+  // Don't touch the text of a note that was never loaded; text() would
+  // request it from the GUI thread, or be empty on a storage thread copy.
+  QString queryString;
+  if ( note->textLoaded() )
+    queryString = "INSERT INTO notes (sync_hash, title, text, date_created, date_modified, "
+                  "notebook, favorited, encrypted, trashed) "
+                  "VALUES (:sync_hash, :title, :text, :date_created, :date_modified, "
+                  ":notebook, :favorited, :encrypted, :trashed)";
+  else
+    queryString = "INSERT INTO notes (sync_hash, title, date_created, date_modified, "
+                  "notebook, favorited, encrypted, trashed) "
+                  "VALUES (:sync_hash, :title, :date_created, :date_modified, "
+                  ":notebook, :favorited, :encrypted, :trashed)";
 
-  QSqlQuery q;
-  q.prepare(queryString);
+  QSqlQuery q = preparedQuery(queryString);
+  QString noteSyncHash = note->syncHash().toString(QUuid::WithoutBraces);
 
-  q.bindValue(":sync_hash"     , note->syncHash().toString(QUuid::WithoutBraces));
+  q.bindValue(":sync_hash"     , noteSyncHash);
   q.bindValue(":title"         , note->title());
-  q.bindValue(":text"          , note->text());
+  if ( note->textLoaded() )
+    q.bindValue(":text"        , note->text());
   q.bindValue(":date_created"  , note->dateCreated());
   q.bindValue(":date_modified" , note->dateModified());
-  q.bindValue(":notebook"      , note->notebook());
+  q.bindValue(":notebook"      , syncHashValue(note->notebook()));
   q.bindValue(":favorited"     , note->favorited());
   q.bindValue(":encrypted"     , note->encrypted());
   q.bindValue(":trashed"       , note->trashed());
 
   q.exec();
+  bool success = logSqlError(q.lastError());
 
   // Set the tags
-  QSqlQuery tagQ;
-  for ( QUuid tagSyncHash : note->tags() ) {
-    tagQ.prepare("insert into notes_tags (note, tag) values "
-              "(:noteSyncHash, :tagSyncHash)");
-    tagQ.bindValue(":noteSyncHash", note->syncHash().toString(QUuid::WithoutBraces));
-    tagQ.bindValue(":tagSyncHash", tagSyncHash);
-    tagQ.exec();
-    logSqlError(tagQ.lastError());
-  }
+  for ( QUuid tagSyncHash : note->tags() )
+    addTagToNote(note->syncHash(), tagSyncHash, true);
 
-  // Print error if there is one. Return true if no error.
-  return logSqlError(q.lastError());
+  // Return true if no error.
+  return success;
 }
 
 bool SQLManager::updateNoteToDB(Note* note) {
   ///
   // Update the note
   ///
+  QString noteSyncHash = note->syncHash().toString(QUuid::WithoutBraces);
 
-  QSqlTableModel model;
-  model.setTable("notes");
-  model.setFilter( QString("sync_hash = \"%1\"").arg(note->syncHash().toString(QUuid::WithoutBraces)) );
-  model.select();
-
-  if ( model.rowCount() > 1 )
-    qWarning() << "[Duplicate Note SQLite3 Warning!] Found" << model.rowCount() << "of" << note->title();
-
-  QSqlRecord noteInDB = model.record(0);
-
-  noteInDB.setValue("title", note->title());
-  noteInDB.setValue("text", note->text());
-  noteInDB.setValue("date_created", note->dateCreated());
-  noteInDB.setValue("date_modified", note->dateModified());
-  noteInDB.setValue("favorited", note->favorited());
-  noteInDB.setValue("notebook", note->notebook());
-  noteInDB.setValue("trashed", note->trashed());
+  // Notes whose text was never loaded keep the text already in the database.
+  QString queryString;
+  if ( note->textLoaded() )
+    queryString = "UPDATE notes SET title = :title, text = :text, date_created = :date_created, "
+                  "date_modified = :date_modified, favorited = :favorited, notebook = :notebook, "
+                  "trashed = :trashed WHERE sync_hash = :sync_hash";
+  else
+    queryString = "UPDATE notes SET title = :title, date_created = :date_created, "
+                  "date_modified = :date_modified, favorited = :favorited, notebook = :notebook, "
+                  "trashed = :trashed WHERE sync_hash = :sync_hash";
+
+  QSqlQuery q = preparedQuery(queryString);
+  if ( note->textLoaded() )
+    q.bindValue(":text", note->text());
+  q.bindValue(":title", note->title());
+  q.bindValue(":date_created", note->dateCreated());
+  q.bindValue(":date_modified", note->dateModified());
+  q.bindValue(":favorited", note->favorited());
+  q.bindValue(":notebook", syncHashValue(note->notebook()));
+  q.bindValue(":trashed", note->trashed());
+  q.bindValue(":sync_hash", noteSyncHash);
+  q.exec();
 
-  model.setRecord(0, noteInDB);
+  if ( q.numRowsAffected() > 1 )
+    qWarning() << "[Duplicate Note SQLite3 Warning!] Found" << q.numRowsAffected() << "of" << note->title();
+  if ( !logSqlError(q.lastError()) )
+    return false;
 
   ///
   // Update the note's tags
   ///
-  QString noteTagsQuery
-    = QString("select note, tag from notes_tags where note = \"%1\"").arg(note->syncHash().toString(QUuid::WithoutBraces));
-  VariantList curTagObjects = column(noteTagsQuery, 1);
-  QVector<QUuid> curTagSyncIDs;
-  for (QVariant obj : curTagObjects)
-    curTagSyncIDs.append(obj.toString());
+  QVector<QUuid> curTagSyncIDs = noteTags(note->syncHash());
 
   // First, loop through note's tags and add to db if needded
   for (QUuid sync_hash : note->tags()) {
     if (!curTagSyncIDs.contains(sync_hash))
-      addTagToNote(note->syncHash(), sync_hash);
+      addTagToNote(note->syncHash(), sync_hash, true);
   }
 
   // Then, loop through db tags and remove ones that are not needed
@@ -365,14 +563,13 @@ bool SQLManager::updateNoteToDB(Note* note) {
     if (!note->tags().contains(syncHash))
       removeTagFromNote(note->syncHash(), syncHash);
   }
-  return logSqlError(model.lastError());
+  return true;
 }
 
 bool SQLManager::updateNoteFromDB(Note* note) {
-  QSqlQuery query;
-  QString queryString
-    = QString("select %1 from notes where sync_hash = :sync_hash").arg(noteColumns().join(", "));
-  query.prepare( queryString );
+  QSqlQuery query = preparedQuery("SELECT sync_hash, title, text, date_created, date_modified, "
+                                  "notebook, favorited, encrypted, trashed "
+                                  "FROM notes WHERE sync_hash = :sync_hash");
   query.bindValue(":sync_hash", note->syncHash().toString(QUuid::WithoutBraces));
   query.exec();
 
@@ -380,6 +577,7 @@ bool SQLManager::updateNoteFromDB(Note* note) {
     return false;
 
   Map noteRow = row(query, noteColumns());
+  query.finish();
 
   note->setSyncHash      ( noteRow["sync_hash"].toString() );
   note->setTitle         ( noteRow["title"].toString() );
@@ -391,41 +589,145 @@ bool SQLManager::updateNoteFromDB(Note* note) {
   note->setEncrypted     ( noteRow["encrypted"].toBool() );
   note->setTrashed       ( noteRow["trashed"].toBool() );
 
-  QSqlTableModel tags;
-  tags.setTable("notes_tags");
-  tags.setFilter( QString("note = \"%1\"").arg(note->syncHash().toString(QUuid::WithoutBraces)) );
-  tags.select();
+  note->setTags( noteTags(note->syncHash()) );
 
-  QVector<QUuid> tagList;
+  return true;
+}
 
-  for (int i=0; i<tags.rowCount(); i++)
-    tagList.append( tags.record(i).value("tag").toString() );
-  note->setTags(tagList);
+bool SQLManager::hasFullTextSearch() const
+{
+  return m_fullTextSearch;
+}
 
-  return logSqlError(tags.lastError());
+QString SQLManager::fullTextQuery(QString searchQuery)
+{
+  // Every word is quoted so FTS5 doesn't treat it as query syntax, and matched
+  // as a prefix so results show up while the last word is still being typed.
+  QStringList terms;
+  for ( QString word : searchQuery.split(QRegExp("\\s+"), QString::SkipEmptyParts) )
+    terms.append( QString("\"%1\"*").arg(word.replace("\"", "\"\"")) );
+  return terms.join(" ");
+}
+
+QVector<NoteSearchResult> SQLManager::searchNotes(QString searchQuery, int limit)
+{
+  QVector<NoteSearchResult> results;
+  QString match = fullTextQuery(searchQuery);
+  if ( match.isEmpty() )
+    return results;
+
+  // Title matches weigh more than body matches. The snippet marks matched
+  // terms with \x02 and \x03, which are turned into offsets below.
+  QSqlQuery q = preparedQuery("SELECT notes.sync_hash, bm25(notes_fts, 10.0, 1.0) AS rank, "
+                              "snippet(notes_fts, -1, char(2), char(3), '...', 12) "
+                              "FROM notes_fts JOIN notes ON notes.id = notes_fts.rowid "
+                              "WHERE notes_fts MATCH :match ORDER BY rank LIMIT :limit");
+  q.bindValue(":match", match);
+  q.bindValue(":limit", limit);
+  if ( !q.exec() ) {
+    logSqlError(q.lastError());
+    return results;
+  }
+  readSearchResults(q, results);
+  return results;
+}
+
+QVector<NoteSearchResult> SQLManager::searchNotesWithin(QString searchQuery, const QVector<QUuid> &noteSyncHashes)
+{
+  QVector<NoteSearchResult> results;
+  QString match = fullTextQuery(searchQuery);
+  if ( match.isEmpty() )
+    return results;
+
+  // bm25 weighs terms by how common they are in the whole index, not just
+  // in one batch, so ranks from different batches can be merged.
+  for ( int first = 0; first < noteSyncHashes.size(); first += NOTE_TEXT_BATCH_SIZE ) {
+    int count = qMin(NOTE_TEXT_BATCH_SIZE, noteSyncHashes.size() - first);
+    QStringList placeholders;
+    for ( int i = 0; i < count; i++ )
+      placeholders.append("?");
+
+    QSqlQuery q(m_sqldb);
+    q.setForwardOnly(true);
+    q.prepare( QString("SELECT notes.sync_hash, bm25(notes_fts, 10.0, 1.0) AS rank, "
+                       "snippet(notes_fts, -1, char(2), char(3), '...', 12) "
+                       "FROM notes_fts JOIN notes ON notes.id = notes_fts.rowid "
+                       "WHERE notes_fts MATCH ? AND notes.sync_hash IN (%1)").arg(placeholders.join(", ")) );
+    q.addBindValue(match);
+    for ( int i = 0; i < count; i++ )
+      q.addBindValue( noteSyncHashes.at(first + i).toString(QUuid::WithoutBraces) );
+    if ( !q.exec() ) {
+      logSqlError(q.lastError());
+      continue;
+    }
+    readSearchResults(q, results);
+  }
+
+  std::stable_sort(results.begin(), results.end(), [](const NoteSearchResult &a, const NoteSearchResult &b) {
+    return a.rank < b.rank;
+  });
+  return results;
+}
+
+QVector<QUuid> SQLManager::notesContaining(const QByteArray &key, const QVector<QUuid> &noteSyncHashes)
+{
+  QVector<QUuid> notes;
+  if ( key.isEmpty() )
+    return notes;
+
+  QHash<QUuid, QString> texts = noteTexts(noteSyncHashes);
+  for ( QUuid syncHash : noteSyncHashes )
+    if ( HelperIO::searchKey(texts.value(syncHash)).contains(key) )
+      notes.append(syncHash);
+  return notes;
+}
+
+void SQLManager::readSearchResults(QSqlQuery &q, QVector<NoteSearchResult> &results)
+{
+  while ( q.next() ) {
+    NoteSearchResult result;
+    result.syncHash = QUuid(q.value(0).toString());
+    result.rank = q.value(1).toDouble();
+
+    QString snippet = q.value(2).toString();
+    int start = -1;
+    for ( QChar c : snippet ) {
+      if ( c == QChar(2) )
+        start = result.snippet.length();
+      else if ( c == QChar(3) && start >= 0 ) {
+        result.highlights.append( qMakePair(start, result.snippet.length() - start) );
+        start = -1;
+      }
+      else
+        result.snippet.append(c);
+    }
+    results.append(result);
+  }
+}
+
+QVector<QUuid> SQLManager::noteTags(QUuid noteSyncHash) {
+  QSqlQuery q = preparedQuery("SELECT tag FROM notes_tags WHERE note = :note");
+  q.bindValue(":note", noteSyncHash.toString(QUuid::WithoutBraces));
+  q.exec();
+  logSqlError(q.lastError());
+
+  QVector<QUuid> tags;
+  while ( q.next() )
+    tags.append( q.value(0).toString() );
+  q.finish();
+  return tags;
 }
 
 bool SQLManager::deleteNote(Note* note) {
-  QSqlQuery q;
-  q.prepare("DELETE FROM notes WHERE sync_hash = :sync_hash");
+  QSqlQuery q = preparedQuery("DELETE FROM notes WHERE sync_hash = :sync_hash");
   q.bindValue(":sync_hash", note->syncHash().toString(QUuid::WithoutBraces));
   q.exec();
   return logSqlError(q.lastError());
 }
 
 bool SQLManager::addNotebook(Notebook* notebook) {
-  QStringList notebookCols = notebookColumns();
-  QStringList columnPlaceholders;
-
-  for (QString col : notebookCols)
-    columnPlaceholders.append( QString(":%1").arg(col) );
-
-  QString queryString = QString("INSERT INTO notebooks (%1) "
-                                "VALUES (%2)").arg(notebookCols.join(", "),
-                                                   columnPlaceholders.join(", "));
-
-  QSqlQuery q;
-  q.prepare(queryString);
+  QSqlQuery q = preparedQuery("INSERT INTO notebooks (sync_hash, title, date_modified, parent, row, encrypted) "
+                              "VALUES (:sync_hash, :title, :date_modified, :parent, :row, :encrypted)");
 
   QString parentSyncHash;
   if ( notebook->parent() != nullptr )
@@ -445,39 +747,35 @@ bool SQLManager::addNotebook(Notebook* notebook) {
 }
 
 bool SQLManager::updateNotebookToDB(Notebook* notebook) {
-  QSqlTableModel model;
-  model.setTable("notebooks");
-  model.setFilter( QString("sync_hash = \"%1\"").arg(notebook->syncHash().toString(QUuid::WithoutBraces)) );
-  model.select();
-
-  if ( model.rowCount() > 1 )
-    qWarning() << "[Duplicate Notebook SQLite3 Warning!] Found" << model.rowCount() << "of" << notebook->title();
-
-  QSqlRecord notebookInDB = model.record(0);
+  QSqlQuery q = preparedQuery("UPDATE notebooks SET title = :title, date_modified = :date_modified, "
+                              "parent = :parent, row = :row, encrypted = :encrypted "
+                              "WHERE sync_hash = :sync_hash");
 
   QString parentSyncHash;
   if ( notebook->parent() != nullptr)
     parentSyncHash = notebook->parent()->syncHash().toString(QUuid::WithoutBraces);
 
-  notebookInDB.setValue("title", notebook->title());
-  notebookInDB.setValue("date_modified", notebook->dateModified());
-  notebookInDB.setValue("parent", parentSyncHash);
-  notebookInDB.setValue("row", notebook->row());
-  notebookInDB.setValue("encrypted", notebook->encrypted());
+  q.bindValue(":title", notebook->title());
+  q.bindValue(":date_modified", notebook->dateModified());
+  q.bindValue(":parent", parentSyncHash);
+  q.bindValue(":row", notebook->row());
+  q.bindValue(":encrypted", notebook->encrypted());
+  q.bindValue(":sync_hash", notebook->syncHash().toString(QUuid::WithoutBraces));
+  q.exec();
 
-  model.setRecord(0, notebookInDB);
+  if ( q.numRowsAffected() > 1 )
+    qWarning() << "[Duplicate Notebook SQLite3 Warning!] Found" << q.numRowsAffected() << "of" << notebook->title();
 
-  return logSqlError(model.lastError());
+  return logSqlError(q.lastError());
 }
 
 bool SQLManager::updateNotebookFromDB(Notebook* notebook) {
-  QSqlQuery query;
-  QString queryString
-    = QString("select %1 from notebooks where sync_hash = :sync_hash").arg(notebookColumns().join(", "));
-  query.prepare( queryString );
+  QSqlQuery query = preparedQuery("SELECT sync_hash, title, date_modified, parent, row, encrypted "
+                                  "FROM notebooks WHERE sync_hash = :sync_hash");
   query.bindValue(":sync_hash", notebook->syncHash().toString(QUuid::WithoutBraces));
   query.exec();
   Map notebookRow = row(query, notebookColumns());
+  query.finish();
 
   if ( !logSqlError(query.lastError()) )
     return false;
@@ -492,39 +790,37 @@ bool SQLManager::updateNotebookFromDB(Notebook* notebook) {
 }
 
 bool SQLManager::deleteNotebook(Notebook* notebook, bool delete_children) {
-  // Delete notebook
-  QSqlQuery q;
-  q.prepare("DELETE FROM notebooks WHERE sync_hash = :sync_hash");
-  q.bindValue(":sync_hash", notebook->syncHash().toString(QUuid::WithoutBraces));
+  QString syncHash = notebook->syncHash().toString(QUuid::WithoutBraces);
+
+  // The notebook, plus every notebook below it if delete_children is set.
+  QString subtree = delete_children ?
+        "WITH RECURSIVE subtree(sync_hash) AS ("
+        "  SELECT :sync_hash "
+        "  UNION ALL "
+        "  SELECT n.sync_hash FROM notebooks n JOIN subtree ON n.parent = subtree.sync_hash"
+        ") " :
+        "WITH subtree(sync_hash) AS (SELECT :sync_hash) ";
+
+  // Change notes under these notebooks to use default notebook
+  QSqlQuery q = preparedQuery(subtree +
+                              "UPDATE notes SET notebook = NULL "
+                              "WHERE notebook IN (SELECT sync_hash FROM subtree)");
+  q.bindValue(":sync_hash", syncHash);
   q.exec();
+  if ( !logSqlError(q.lastError()) )
+    return false;
 
-  // Change notes under this notebook to use default notebook
-  logSqlError(q.lastError());
-  q.prepare("UPDATE notes SET notebook = NULL WHERE notebook = :sync_hash");
-  q.bindValue(":sync_hash", notebook->syncHash().toString(QUuid::WithoutBraces));
+  // Delete the notebooks
+  q = preparedQuery(subtree + "DELETE FROM notebooks WHERE sync_hash IN (SELECT sync_hash FROM subtree)");
+  q.bindValue(":sync_hash", syncHash);
   q.exec();
 
-  // Delete children
-  if ( delete_children )
-    for (Notebook *child : m_getNotebooks(notebook) )
-      deleteNotebook(child, false);
-
   return logSqlError(q.lastError());
 }
 
 bool SQLManager::addTag(Tag *tag) {
-  QStringList tagCols = tagColumns();
-  QStringList columnPlaceholders;
-
-  for (QString col : tagCols)
-    columnPlaceholders.append( QString(":%1").arg(col) );
-
-  QString queryString = QString("INSERT INTO tags (%1) "
-                                "VALUES (%2)").arg(tagCols.join(", "),
-                                                   columnPlaceholders.join(", "));
-
-  QSqlQuery q;
-  q.prepare(queryString);
+  QSqlQuery q = preparedQuery("INSERT INTO tags (sync_hash, title, date_modified, row, encrypted) "
+                              "VALUES (:sync_hash, :title, :date_modified, :row, :encrypted)");
 
   q.bindValue(":sync_hash", tag->syncHash().toString(QUuid::WithoutBraces));
   q.bindValue(":title", tag->title());
@@ -539,32 +835,28 @@ bool SQLManager::addTag(Tag *tag) {
 }
 
 bool SQLManager::updateTagToDB(Tag* tag) {
-  QSqlTableModel model;
-  model.setTable("tags");
-  model.setFilter( QString("sync_hash = \"%1\"").arg(tag->syncHash().toString(QUuid::WithoutBraces)) );
-  model.select();
-
-  if ( model.rowCount() > 1 )
-    qWarning() << "[Duplicate Tag SQLite3 Warning!] Found" << model.rowCount() << "of" << tag->title();
+  QSqlQuery q = preparedQuery("UPDATE tags SET title = :title, date_modified = :date_modified, "
+                              "row = :row, encrypted = :encrypted WHERE sync_hash = :sync_hash");
+  q.bindValue(":title", tag->title());
+  q.bindValue(":date_modified", tag->dateModified());
+  q.bindValue(":row", tag->row());
+  q.bindValue(":encrypted", tag->encrypted());
+  q.bindValue(":sync_hash", tag->syncHash().toString(QUuid::WithoutBraces));
+  q.exec();
 
-  QSqlRecord tagInDB = model.record(0);
-  tagInDB.setValue("title", tag->title());
-  tagInDB.setValue("date_modified", tag->dateModified());
-  tagInDB.setValue("row", tag->row());
-  tagInDB.setValue("encrypted", tag->encrypted());
-  model.setRecord(0, tagInDB);
+  if ( q.numRowsAffected() > 1 )
+    qWarning() << "[Duplicate Tag SQLite3 Warning!] Found" << q.numRowsAffected() << "of" << tag->title();
 
-  return logSqlError(model.lastError());
+  return logSqlError(q.lastError());
 }
 
 bool SQLManager::updateTagFromDB(Tag* tag) {
-  QSqlQuery query;
-  QString queryString
-    = QString("select %1 from tags where sync_hash = :sync_hash").arg(tagColumns().join(", "));
-  query.prepare( queryString );
+  QSqlQuery query = preparedQuery("SELECT sync_hash, title, date_modified, row, encrypted "
+                                  "FROM tags WHERE sync_hash = :sync_hash");
   query.bindValue(":sync_hash", tag->syncHash().toString(QUuid::WithoutBraces));
   query.exec();
   Map tagRow = row(query, tagColumns());
+  query.finish();
 
   if ( !logSqlError(query.lastError()) )
     return false;
@@ -578,31 +870,32 @@ bool SQLManager::updateTagFromDB(Tag* tag) {
 }
 
 bool SQLManager::deleteTag(Tag* tag) {
-  QSqlQuery q;
-  q.prepare("DELETE FROM tags WHERE sync_hash = :sync_hash");
-  q.bindValue(":sync_hash", tag->syncHash().toString(QUuid::WithoutBraces));
+  QString syncHash = tag->syncHash().toString(QUuid::WithoutBraces);
+  QSqlQuery q = preparedQuery("DELETE FROM tags WHERE sync_hash = :sync_hash");
+  q.bindValue(":sync_hash", syncHash);
   q.exec();
   logSqlError(q.lastError());
-  q.prepare("DELETE FROM notes_tags WHERE tag = :sync_hash");
-  q.bindValue(":sync_hash", tag->syncHash().toString(QUuid::WithoutBraces));
+  q = preparedQuery("DELETE FROM notes_tags WHERE tag = :sync_hash");
+  q.bindValue(":sync_hash", syncHash);
   q.exec();
   return logSqlError(q.lastError());
 }
 
 bool SQLManager::tagExists(QUuid noteSyncHash, QUuid tagSyncHash) {
-  QSqlTableModel model;
-  model.setTable("notes_tags");
-  model.setFilter( QString("note = \"%1\" and tag = \"%2\"").arg(noteSyncHash.toString(QUuid::WithoutBraces), tagSyncHash.toString(QUuid::WithoutBraces)) );
-  model.select();
-  return model.rowCount() > 0;
+  QSqlQuery q = preparedQuery("SELECT 1 FROM notes_tags WHERE note = :noteSyncHash AND tag = :tagSyncHash LIMIT 1");
+  q.bindValue(":noteSyncHash", noteSyncHash.toString(QUuid::WithoutBraces));
+  q.bindValue(":tagSyncHash", tagSyncHash.toString(QUuid::WithoutBraces));
+  q.exec();
+  bool exists = logSqlError(q.lastError()) && q.next();
+  q.finish();
+  return exists;
 }
 
 bool SQLManager::addTagToNote(QUuid noteSyncHash, QUuid tagSyncHash, bool skip_duplicate_check) {
   if ( !skip_duplicate_check && tagExists(noteSyncHash, tagSyncHash) )
     return true;
-  QSqlQuery q;
-  q.prepare("INSERT INTO notes_tags (note, tag) VALUES "
-            "(:noteSyncHash, :tagSyncHash)");
+  QSqlQuery q = preparedQuery("INSERT INTO notes_tags (note, tag) VALUES "
+                              "(:noteSyncHash, :tagSyncHash)");
   q.bindValue(":noteSyncHash", noteSyncHash.toString(QUuid::WithoutBraces));
   q.bindValue(":tagSyncHash", tagSyncHash.toString(QUuid::WithoutBraces));
   q.exec();
@@ -610,15 +903,62 @@ bool SQLManager::addTagToNote(QUuid noteSyncHash, QUuid tagSyncHash, bool skip_d
 }
 
 bool SQLManager::removeTagFromNote(QUuid noteSyncHash, QUuid tagSyncHash) {
-  QSqlQuery q;
-  q.prepare("DELETE FROM notes_tags WHERE "
-            "note = :noteSyncHash and tag = :tagSyncHash");
-  q.bindValue(":noteSyncHash", noteSyncHash);
-  q.bindValue(":tagSyncHash", tagSyncHash);
+  QSqlQuery q = preparedQuery("DELETE FROM notes_tags WHERE "
+                              "note = :noteSyncHash and tag = :tagSyncHash");
+  q.bindValue(":noteSyncHash", noteSyncHash.toString(QUuid::WithoutBraces));
+  q.bindValue(":tagSyncHash", tagSyncHash.toString(QUuid::WithoutBraces));
   q.exec();
   return logSqlError(q.lastError());
 }
 
+bool SQLManager::statementCacheEnabled() const
+{
+  return m_statementCacheEnabled;
+}
+
+void SQLManager::setStatementCacheEnabled(bool enabled)
+{
+  m_statementCacheEnabled = enabled;
+  if ( !enabled )
+    clearStatementCache();
+}
+
+void SQLManager::clearStatementCache()
+{
+  m_statementCache.clear();
+}
+
+int SQLManager::statementCacheSize() const
+{
+  return m_statementCache.size();
+}
+
+int SQLManager::statementCacheHits() const
+{
+  return m_statementCacheHits;
+}
+
+QSqlQuery SQLManager::preparedQuery(const QString &statement)
+{
+  if ( m_statementCacheEnabled ) {
+    QHash<QString, QSqlQuery>::const_iterator cached = m_statementCache.constFind(statement);
+    if ( cached != m_statementCache.constEnd() ) {
+      m_statementCacheHits++;
+      return cached.value();
+    }
+  }
+
+  QSqlQuery q(m_sqldb);
+  if ( !q.prepare(statement) )
+    logSqlError(q.lastError());
+
+  // QSqlQuery is implicitly shared, so the copy handed out
+  // and the cached one use the same prepared statement.
+  if ( m_statementCacheEnabled )
+    m_statementCache.insert(statement, q);
+  return q;
+}
+
 void SQLManager::importTutorialNotes() {
   QString welcomeText = HelperIO::fileToQString(":/tutorial/1-welcome.md");
   QDateTime now = QDateTime::currentDateTime();
@@ -627,3 +967,188 @@ void SQLManager::importTutorialNotes() {
   welcome.setText(welcomeText);
   addNote(&welcome);
 }
+
+void SQLManager::startStorageThread()
+{
+  if ( m_storageThread != nullptr )
+    return;
+  m_storageThread = new StorageThread(this);
+  connect(m_storageThread, &StorageThread::committed,
+          this, &SQLManager::committed);
+  m_storageThread->start();
+}
+
+void SQLManager::stopStorageThread()
+{
+  if ( m_storageThread == nullptr )
+    return;
+  m_storageThread->stop();
+  delete m_storageThread;
+  m_storageThread = nullptr;
+}
+
+bool SQLManager::hasStorageThread() const
+{
+  return m_storageThread != nullptr;
+}
+
+quint64 SQLManager::post(StorageThread::Mutation mutation)
+{
+  if ( m_storageThread != nullptr )
+    return m_storageThread->post(mutation);
+
+  bool inTransaction = transaction();
+  bool success = mutation(this);
+  if ( inTransaction ) {
+    if ( success )
+      success = commit();
+    else
+      rollback();
+  }
+  emit committed(++m_inlineTicket, success);
+  return m_inlineTicket;
+}
+
+void SQLManager::barrier()
+{
+  if ( m_storageThread != nullptr )
+    m_storageThread->barrier();
+}
+
+quint64 SQLManager::postAddNote(Note *note)
+{
+  return post( noteMutation(note, &SQLManager::addNote) );
+}
+
+quint64 SQLManager::postUpdateNote(Note *note)
+{
+  return post( noteMutation(note, &SQLManager::updateNoteToDB) );
+}
+
+quint64 SQLManager::postDeleteNote(QUuid noteSyncHash)
+{
+  return post([noteSyncHash](SQLManager *sql) {
+      Note note(noteSyncHash);
+      return sql->deleteNote(&note);
+    });
+}
+
+quint64 SQLManager::postUpdateNotes(QVector<Note*> notes)
+{
+  QVector<StorageThread::Mutation> mutations;
+  mutations.reserve(notes.size());
+  for (Note *note : notes)
+    mutations.append( noteMutation(note, &SQLManager::updateNoteToDB) );
+
+  return post([mutations](SQLManager *sql) {
+      for (const StorageThread::Mutation &mutation : mutations)
+        if ( !mutation(sql) )
+          return false;
+      return true;
+    });
+}
+
+quint64 SQLManager::postDeleteNotes(QVector<QUuid> noteSyncHashes)
+{
+  return post([noteSyncHashes](SQLManager *sql) {
+      for (QUuid noteSyncHash : noteSyncHashes) {
+        Note note(noteSyncHash);
+        if ( !sql->deleteNote(&note) )
+          return false;
+      }
+      return true;
+    });
+}
+
+quint64 SQLManager::postAddNotebook(Notebook *notebook)
+{
+  return post( notebookMutation(notebook, &SQLManager::addNotebook) );
+}
+
+quint64 SQLManager::postUpdateNotebook(Notebook *notebook)
+{
+  return post( notebookMutation(notebook, &SQLManager::updateNotebookToDB) );
+}
+
+quint64 SQLManager::postDeleteNotebook(QUuid notebookSyncHash)
+{
+  return post([notebookSyncHash](SQLManager *sql) {
+      Notebook notebook(notebookSyncHash);
+      return sql->deleteNotebook(&notebook);
+    });
+}
+
+quint64 SQLManager::postAddTag(Tag *tag)
+{
+  return post( tagMutation(tag, &SQLManager::addTag) );
+}
+
+quint64 SQLManager::postUpdateTag(Tag *tag)
+{
+  return post( tagMutation(tag, &SQLManager::updateTagToDB) );
+}
+
+quint64 SQLManager::postDeleteTag(QUuid tagSyncHash)
+{
+  return post([tagSyncHash](SQLManager *sql) {
+      Tag tag(tagSyncHash);
+      return sql->deleteTag(&tag);
+    });
+}
+
+StorageThread::Mutation SQLManager::noteMutation(Note *note, bool (SQLManager::*write)(Note *))
+{
+  // Copy the note's fields. The copy is rebuilt on the storage thread.
+  QUuid sync_hash         = note->syncHash();
+  QString title           = note->title();
+  bool textLoaded         = note->textLoaded();
+  QString text            = textLoaded ? note->text() : QString();
+  QDateTime date_created  = note->dateCreated();
+  QDateTime date_modified = note->dateModified();
+  QUuid notebook          = note->notebook();
+  QVector<QUuid> tags     = note->tags();
+  bool favorited          = note->favorited();
+  bool encrypted          = note->encrypted();
+  bool trashed            = note->trashed();
+
+  return [=](SQLManager *sql) {
+    Note copy(sync_hash, title, text, date_created, date_modified,
+              notebook, tags, favorited, encrypted, trashed);
+    if ( !textLoaded )
+      copy.unloadText();
+    return (sql->*write)(&copy);
+  };
+}
+
+StorageThread::Mutation SQLManager::notebookMutation(Notebook *notebook, bool (SQLManager::*write)(Notebook *))
+{
+  QUuid sync_hash         = notebook->syncHash();
+  QString title           = notebook->title();
+  QDateTime date_modified = notebook->dateModified();
+  bool hasParent          = notebook->parent() != nullptr;
+  QUuid parent            = hasParent ? notebook->parent()->syncHash() : QUuid();
+  int row                 = notebook->row();
+  bool encrypted          = notebook->encrypted();
+
+  return [=](SQLManager *sql) {
+    // Only the parent's sync hash is needed to write the notebook.
+    Notebook parentCopy(parent);
+    Notebook copy(sync_hash, title, date_modified,
+                  hasParent ? &parentCopy : nullptr, row, encrypted);
+    return (sql->*write)(&copy);
+  };
+}
+
+StorageThread::Mutation SQLManager::tagMutation(Tag *tag, bool (SQLManager::*write)(Tag *))
+{
+  QUuid sync_hash         = tag->syncHash();
+  QString title           = tag->title();
+  QDateTime date_modified = tag->dateModified();
+  int row                 = tag->row();
+  bool encrypted          = tag->encrypted();
+
+  return [=](SQLManager *sql) {
+    Tag copy(sync_hash, title, date_modified, row, encrypted);
+    return (sql->*write)(&copy);
+  };
+}
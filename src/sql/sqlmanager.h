@@ -3,21 +3,43 @@
 #include <QObject>
 #include <QSqlDatabase>
 #include <QMap>
+#include <QHash>
+#include <QSqlQuery>
 #include <QVector>
 #include <QFile>
 #include <QUuid>
+#include <functional>
 #include "../meta/note.h"
+#include "storagethread.h"
+
+#define NOTE_TEXT_BATCH_SIZE 500 // Notes per query in noteTexts()
 
 // A 2d array.
 typedef QMap<QString, QVariant> Map;
 typedef QVector<Map>            MapVector;
 typedef QVector<QVariant>       VariantList;
 
+// A note matched by a full-text search
+struct NoteSearchResult {
+  QUuid syncHash;
+  // bm25 score, lower is better.
+  double rank=0;
+  // Matching excerpt and the (offset, length) of every matched term in it.
+  QString snippet;
+  QVector<QPair<int,int>> highlights;
+};
+
 class SQLManager : public QObject
 {
   Q_OBJECT
 public:
-  explicit SQLManager(QObject *parent = nullptr);
+  // If prepareSchema is false, only the connection is opened. The storage
+  // thread uses that, since the GUI connection already created and
+  // migrated the tables.
+  explicit SQLManager(QObject *parent = nullptr,
+                      QString connectionName = QLatin1String(QSqlDatabase::defaultConnection),
+                      bool prepareSchema = true);
+  ~SQLManager();
   void close();
 
   QString location() const;
@@ -41,12 +63,25 @@ public:
   MapVector rows(QSqlQuery query, QStringList tableLabels);
   MapVector rows(QString queryString, QStringList tableLabels);
 
+  // Transactions on Vibrato's database connection
+  bool transaction();
+  bool commit();
+  bool rollback();
+
   bool runScript(QString fileName);
   bool runScript(QFile *file, QSqlQuery *query);
 
+  // Schema versioning. The version is kept in sqlite's user_version pragma
+  // and migrate() applies the scripts in resources/sql/migrations in order.
+  int  schemaVersion();
+  bool migrate();
+
   // Log SQL error to console. Returns false if error.
   bool logSqlError(QSqlError error, bool fatal=false);
 
+  // How sync hashes are bound to queries: without braces, or NULL if nil.
+  static QVariant syncHashValue(QUuid syncHash);
+
   /*
    * Vibrato-specific SQL functions
    */
@@ -56,7 +91,14 @@ public:
   QStringList tagColumns() const;
 
   // Retrieve notes
-  QVector<Note*> notes();
+  // If metadataOnly is true, only an excerpt of each note's text is loaded.
+  // The full text can be fetched later on with noteText().
+  QVector<Note*> notes(bool metadataOnly=false);
+  QString noteText(QUuid noteSyncHash);
+  // Text of several notes at once, by sync hash.
+  QHash<QUuid, QString> noteTexts(const QVector<QUuid> &noteSyncHashes);
+  // Streams the text of every note, one row at a time.
+  void forEachNoteText(std::function<void(QUuid, const QString&)> function);
   QVector<Notebook*> notebooks();
   QVector<Tag*> tags();
 
@@ -68,6 +110,8 @@ public:
   bool addNotebook(Notebook *notebook);
   bool updateNotebookToDB(Notebook *notebook);
   bool updateNotebookFromDB(Notebook *notebook);
+  // Should run as a single mutation, so the notes and notebooks are
+  // updated inside the same transaction. (see postDeleteNotebook)
   bool deleteNotebook(Notebook *notebook, bool delete_children=true);
 
   bool addTag(Tag *tag);
@@ -75,7 +119,19 @@ public:
   bool updateTagFromDB(Tag *tag);
   bool deleteTag(Tag *tag);
 
+  QVector<QUuid> noteTags(QUuid noteSyncHash);
   bool tagExists(QUuid noteSyncHash, QUuid tagSyncHash);
+
+  // Full-text search over note titles and bodies. Results are sorted
+  // best match first. A limit of -1 returns every match.
+  // hasFullTextSearch() is looked up once, by migrate().
+  bool hasFullTextSearch() const;
+  static QString fullTextQuery(QString searchQuery);
+  QVector<NoteSearchResult> searchNotes(QString searchQuery, int limit=-1);
+  // Same, but only among the given notes.
+  QVector<NoteSearchResult> searchNotesWithin(QString searchQuery, const QVector<QUuid> &noteSyncHashes);
+  // The given notes whose folded text contains key. (see HelperIO::searchKey)
+  QVector<QUuid> notesContaining(const QByteArray &key, const QVector<QUuid> &noteSyncHashes);
   // If skip_duplicate_check is set to true, it will not check for a duplicate entry
   // before adding the tag to note. This will save you from an extra database call.
   bool addTagToNote(QUuid noteSyncHash, QUuid tagSyncHash, bool skip_duplicate_check=false);
@@ -83,7 +139,44 @@ public:
 
   void importTutorialNotes();
 
+  // Statements used by the functions above are prepared once and reused.
+  // The cache can be turned off, ex. to benchmark it.
+  bool statementCacheEnabled() const;
+  void setStatementCacheEnabled(bool enabled);
+  void clearStatementCache();
+  int  statementCacheSize() const;
+  int  statementCacheHits() const; // Statements handed out without preparing them again
+
+  /*
+   * Writes from the in-memory databases go through the storage thread.
+   * Until startStorageThread() is called, mutations run right away on the
+   * calling thread instead.
+   */
+  void startStorageThread();
+  void stopStorageThread();
+  bool hasStorageThread() const;
+
+  quint64 post(StorageThread::Mutation mutation);
+  // Blocks until every posted mutation is committed to disk.
+  void barrier();
+
+  // These functions copy the object's current state and post a mutation
+  // that writes it.
+  quint64 postAddNote(Note *note);
+  quint64 postUpdateNote(Note *note);
+  quint64 postDeleteNote(QUuid noteSyncHash);
+  // Same as above, for many notes in a single transaction.
+  quint64 postUpdateNotes(QVector<Note*> notes);
+  quint64 postDeleteNotes(QVector<QUuid> noteSyncHashes);
+  quint64 postAddNotebook(Notebook *notebook);
+  quint64 postUpdateNotebook(Notebook *notebook);
+  quint64 postDeleteNotebook(QUuid notebookSyncHash);
+  quint64 postAddTag(Tag *tag);
+  quint64 postUpdateTag(Tag *tag);
+  quint64 postDeleteTag(QUuid tagSyncHash);
+
 signals:
+  void committed(quint64 ticket, bool success);
 
 public slots:
 
@@ -92,8 +185,22 @@ private:
   QSqlDatabase m_sqldb;
 
   bool m_shouldImportTutorialNotes = false;
+  bool m_fullTextSearch = false;
+
+  bool applyMigrations();
+  void readSearchResults(QSqlQuery &q, QVector<NoteSearchResult> &results);
+
+  QHash<QString, QSqlQuery> m_statementCache;
+  bool m_statementCacheEnabled = true;
+  int m_statementCacheHits = 0;
+  QSqlQuery preparedQuery(const QString &statement);
+
+  StorageThread *m_storageThread = nullptr;
+  quint64 m_inlineTicket = 0;
 
-  QVector<Notebook*> m_getNotebooks(Notebook *parent=nullptr);
+  StorageThread::Mutation noteMutation(Note *note, bool (SQLManager::*write)(Note *));
+  StorageThread::Mutation notebookMutation(Notebook *notebook, bool (SQLManager::*write)(Notebook *));
+  StorageThread::Mutation tagMutation(Tag *tag, bool (SQLManager::*write)(Tag *));
 
   QStringList m_noteColumns =
     {"sync_hash",
@@ -0,0 +1,91 @@
+#include "storagethread.h"
+#include "sqlmanager.h"
+#include <QSqlDatabase>
+#include <QMutexLocker>
+#include <QDebug>
+
+StorageThread::StorageThread(QObject *parent) :
+  QThread(parent)
+{
+}
+
+StorageThread::~StorageThread()
+{
+  stop();
+}
+
+quint64 StorageThread::post(Mutation mutation)
+{
+  QMutexLocker locker(&m_mutex);
+  quint64 ticket = ++m_postedTicket;
+  m_queue.enqueue( qMakePair(ticket, mutation) );
+  m_mutationPosted.wakeOne();
+  return ticket;
+}
+
+void StorageThread::barrier()
+{
+  QMutexLocker locker(&m_mutex);
+  if ( !isRunning() )
+    return;
+  while ( m_committedTicket < m_postedTicket )
+    m_mutationCommitted.wait(&m_mutex);
+}
+
+void StorageThread::stop()
+{
+  if ( !isRunning() )
+    return;
+  {
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_mutationPosted.wakeOne();
+  }
+  wait();
+}
+
+quint64 StorageThread::committedTicket()
+{
+  QMutexLocker locker(&m_mutex);
+  return m_committedTicket;
+}
+
+void StorageThread::run()
+{
+  {
+    // The connection has to be created on the thread that uses it.
+    SQLManager sqlManager(nullptr, STORAGE_THREAD_CONNECTION, false);
+
+    forever {
+      QMutexLocker locker(&m_mutex);
+      while ( m_queue.isEmpty() && !m_stopping )
+        m_mutationPosted.wait(&m_mutex);
+      if ( m_queue.isEmpty() )
+        break; // Stopping and nothing left to write
+      QPair<quint64, Mutation> item = m_queue.dequeue();
+      locker.unlock();
+
+      // Every mutation is applied in its own transaction.
+      bool inTransaction = sqlManager.transaction();
+      bool success = item.second(&sqlManager);
+      if ( inTransaction ) {
+        if ( success )
+          success = sqlManager.commit();
+        else
+          sqlManager.rollback();
+      }
+      if ( !success )
+        qWarning() << "[StorageThread] Mutation" << item.first << "failed.";
+
+      locker.relock();
+      m_committedTicket = item.first;
+      m_mutationCommitted.wakeAll();
+      locker.unlock();
+
+      emit committed(item.first, success);
+    }
+
+    sqlManager.close();
+  }
+  QSqlDatabase::removeDatabase(STORAGE_THREAD_CONNECTION);
+}
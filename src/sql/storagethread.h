@@ -0,0 +1,62 @@
+/*
+ * StorageThread
+ * A dedicated thread that owns its own connection to Vibrato's sqlite3
+ * database and applies writes in the exact order they were posted.
+ *
+ * Writes are posted as mutations: functions that receive the thread's
+ * SQLManager. A mutation must not touch objects living on the GUI thread,
+ * so callers capture a copy of whatever data they need to write.
+ */
+
+#ifndef STORAGETHREAD_H
+#define STORAGETHREAD_H
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QPair>
+#include <functional>
+
+#define STORAGE_THREAD_CONNECTION "vibrato-storage"
+
+class SQLManager;
+
+class StorageThread : public QThread
+{
+  Q_OBJECT
+public:
+  typedef std::function<bool(SQLManager *sqlManager)> Mutation;
+
+  explicit StorageThread(QObject *parent = nullptr);
+  ~StorageThread();
+
+  // Queues a mutation and returns its ticket. Tickets increase in the
+  // order mutations are applied.
+  quint64 post(Mutation mutation);
+
+  // Blocks until every mutation posted so far has been committed.
+  void barrier();
+
+  // Commits the remaining mutations and ends the thread.
+  void stop();
+
+  quint64 committedTicket();
+
+signals:
+  void committed(quint64 ticket, bool success);
+
+protected:
+  void run() override;
+
+private:
+  QMutex m_mutex;
+  QWaitCondition m_mutationPosted;
+  QWaitCondition m_mutationCommitted;
+  QQueue< QPair<quint64, Mutation> > m_queue;
+
+  quint64 m_postedTicket=0;
+  quint64 m_committedTicket=0;
+  bool m_stopping=false;
+};
+
+#endif // STORAGETHREAD_H
@@ -103,6 +103,8 @@ void EscribaManager::setNote( Note *note )
                this, &EscribaManager::updateFavoriteButton);
     disconnect(m_curNote, &Note::trashedOrRestored,
             this, &EscribaManager::updateTrashButton);
+    // Hand the note we are leaving to the storage thread, without waiting
+    m_db->noteDatabase()->saveQueue()->flush();
   } else if (!curNoteExists) {
     m_curNote = nullptr;
     m_sync_hash = nullptr;
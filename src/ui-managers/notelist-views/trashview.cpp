@@ -9,7 +9,8 @@
 TrashView::TrashView(Database *db, Manager *manager, QObject *parent) :
   GenericView(db, manager, parent)
 {
-
+  m_trashModel = new TrashListModel(db->noteDatabase(), this);
+  m_trashDelegate = new TrashItemDelegate(m_trashModel, db->noteDatabase(), this);
 }
 
 void TrashView::activateView()
@@ -23,15 +24,14 @@ void TrashView::activateView()
   nlm->disconnectCurrentView();
   nlm->setTitle("Trash");
 
-  // Create the trash list widget
-  m_trashListWidget = new QListWidget();
-  int trashCount = 0;
-  for ( Note *note : db()->noteDatabase()->list() )
-    if ( note->trashed() ) {
-      addItem(note);
-      trashCount++;
-    }
-  nlm->setMetrics(trashCount, "note");
+  // Create the trash list view. Only the visible rows get painted,
+  // however many notes are in the trash.
+  m_trashListView = new QListView();
+  m_trashListView->setUniformItemSizes(true);
+  m_trashListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  m_trashListView->setModel(m_trashModel);
+  m_trashListView->setItemDelegate(m_trashDelegate);
+  updateMetrics();
 
   nlm->clearFilter(false);
   proxyModel()->filterOutEverything();
@@ -78,29 +78,33 @@ void TrashView::activateView()
 
   // Add the mass actions and trash list widget to screen
   notelistlayout->addWidget(m_massActions);
-  notelistlayout->addWidget(m_trashListWidget);
+  notelistlayout->addWidget(m_trashListView);
 
   // Signals
   connect(m_checkbox, &QCheckBox::stateChanged,
           this, &TrashView::toggleMassCheckmark);
-  connect(m_trashListWidget, &QListWidget::currentItemChanged,
-          this, &TrashView::selectionChanged);
+  connect(m_trashListView->selectionModel(), &QItemSelectionModel::currentChanged,
+          this, &TrashView::currentChanged);
+  connect(m_trashListView->selectionModel(), &QItemSelectionModel::selectionChanged,
+          this, &TrashView::determineMassActionVisibility);
+  connect(m_trashModel, &TrashListModel::rowsInserted,
+          this, &TrashView::updateMetrics);
+  connect(m_trashModel, &TrashListModel::rowsRemoved,
+          this, &TrashView::updateMetrics);
 
-  // Show the trash list widget
-  m_trashListWidget->show();
+  // Show the trash list view
+  m_trashListView->show();
 }
 
 void TrashView::deactivateView()
 {
-  // Delete trash list widget
+  disconnect(m_trashModel, nullptr, this, nullptr);
+
+  // Delete trash list view
   delete m_massActions;
-  delete m_trashListWidget;
+  delete m_trashListView;
   m_massActions = nullptr;
-  m_trashListWidget = nullptr;
-
-  // Clear lists
-  m_trashItems.clear();
-  m_selectedTrashItems.clear();
+  m_trashListView = nullptr;
 
   addonsWidgetUi()->buttonBox->hide();
 
@@ -108,40 +112,28 @@ void TrashView::deactivateView()
   listView()->show();
 }
 
-TrashItem* TrashView::addItem(Note* note) {
-  TrashItem *item = new TrashItem(note, m_trashListWidget);
-  m_trashItems.append(item);
-  connect(item, &TrashItem::itemCheckedOrUnchecked,
-          this, &TrashView::itemCheckedOrUncheckedOrRemoved);
-  connect(item, &TrashItem::pleaseDeleteTrashItem,
-          this, &TrashView::deleteTrashItem);
-  connect(item, &TrashItem::deleteNote,
-          this, &TrashView::deleteNote);
-  connect(item, &TrashItem::restoreNote,
-          this, &TrashView::restoreNote);
-  return item;
-}
-
-void TrashView::select(TrashItem* item) {
-  item->checkbox()->setChecked(true);
+TrashListModel *TrashView::model() const
+{
+  return m_trashModel;
 }
 
-void TrashView::deselect(TrashItem* item) {
-  item->checkbox()->setChecked(false);
+QVector<Note*> TrashView::selectedNotes() const
+{
+  if ( m_trashListView == nullptr )
+    return QVector<Note*>();
+  return m_trashModel->notesInSelection( m_trashListView->selectionModel()->selection() );
 }
 
 void TrashView::selectAll() {
-  for ( TrashItem *item : m_trashItems )
-    select(item);
+  m_trashListView->selectAll();
 }
 
 void TrashView::deselectAll() {
-  for ( TrashItem *item : m_trashItems )
-    deselect(item);
+  m_trashListView->clearSelection();
 }
 
 void TrashView::determineMassActionVisibility(void) {
-  if ( m_selectedTrashItems.length() > 0 ) {
+  if ( m_trashListView != nullptr && m_trashListView->selectionModel()->hasSelection() ) {
     m_massRestore->show();
     m_massDelete->show();
   }
@@ -151,44 +143,24 @@ void TrashView::determineMassActionVisibility(void) {
   }
 }
 
-void TrashView::selectionChanged(QListWidgetItem* current, QListWidgetItem* previous) {
-  TrashItem *trashItemCur = static_cast<TrashItem*>(current);
-  // For safety. If trash item list does not contain the current item, return.
-  if ( !m_trashItems.contains(trashItemCur) )
+void TrashView::currentChanged(const QModelIndex &current, const QModelIndex &previous) {
+  Note *note = m_trashModel->noteFromIndex(current);
+  if ( note == nullptr )
     return;
 
-  manager()->escribaManager()->setNote( trashItemCur->note() );
+  manager()->escribaManager()->setNote(note);
 }
 
-void TrashView::deleteSelectedNotes() {
-  for (int i=m_selectedTrashItems.length()-1; i>=0; i--) {
-    TrashItem *item = m_selectedTrashItems[i];
-    deleteNote(item->note());
-    deleteTrashItem(item);
-  }
+void TrashView::updateMetrics(void) {
+  manager()->noteListManager()->setMetrics(m_trashModel->rowCount(), "note");
 }
 
-void TrashView::restoreSelectedNotes() {
-  for (int i=m_selectedTrashItems.length()-1; i>=0; i--) {
-    TrashItem *item = m_selectedTrashItems[i];
-    restoreNote(item->note());
-  }
-}
-
-void TrashView::deleteTrashItem(TrashItem* item) {
-  m_trashItems.removeAll(item);
-  m_selectedTrashItems.removeAll(item);
-  m_trashListWidget->removeItemWidget(item);
-  itemCheckedOrUncheckedOrRemoved(nullptr);
-  delete item;
-}
-
-void TrashView::deleteNote(Note* note) {
-  db()->noteDatabase()->removeNote(note);
+void TrashView::deleteSelectedNotes() {
+  db()->noteDatabase()->removeNotes( selectedNotes() );
 }
 
-void TrashView::restoreNote(Note* note) {
-  note->setTrashed(false);
+void TrashView::restoreSelectedNotes() {
+  db()->noteDatabase()->restoreNotes( selectedNotes() );
 }
 
 void TrashView::toggleMassCheckmark(void) {
@@ -198,18 +170,3 @@ void TrashView::toggleMassCheckmark(void) {
   else
     deselectAll();
 }
-
-void TrashView::itemCheckedOrUncheckedOrRemoved(TrashItem *item) {
-  if ( item != nullptr ) {
-    if ( item->checked() ) {
-      if ( !m_selectedTrashItems.contains(item) ) {
-        m_selectedTrashItems.append(item);
-      }
-    }
-    else {
-      if ( m_selectedTrashItems.contains(item) )
-        m_selectedTrashItems.removeAll(item);
-    }
-  }
-  determineMassActionVisibility();
-}
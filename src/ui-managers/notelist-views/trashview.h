@@ -1,12 +1,14 @@
 #ifndef TRASHVIEW_H
 #define TRASHVIEW_H
 #include <QObject>
-#include <QListWidget>
+#include <QListView>
+#include <QItemSelection>
 #include <QVector>
 #include <QCheckBox>
 #include <QToolButton>
 #include "genericview.h"
-#include "../../../ui/trashitem.h"
+#include "../../models/trashlistmodel.h"
+#include "../../models/delegates/trashitemdelegate.h"
 #include "../../meta/note.h"
 
 class TrashView : public GenericView
@@ -17,31 +19,28 @@ public:
   void activateView() override;
   void deactivateView() override;
 
-  TrashItem *addItem(Note *note);
+  TrashListModel *model() const;
+  QVector<Note*> selectedNotes() const;
 
-  void select(TrashItem *item);
-  void deselect(TrashItem *item);
   void selectAll();
   void deselectAll();
 
 private slots:
   void determineMassActionVisibility(void);
-  void selectionChanged(QListWidgetItem *current, QListWidgetItem *previous);
+  void currentChanged(const QModelIndex &current, const QModelIndex &previous);
+  void updateMetrics(void);
 
   void deleteSelectedNotes();
   void restoreSelectedNotes();
 
-  void deleteTrashItem(TrashItem *item);
-
-  void deleteNote(Note *note);
-  void restoreNote(Note *note);
-
 private:
-  QListWidget *m_trashListWidget=nullptr;
-  QWidget *m_massActions=nullptr;
+  // The model follows the trash all the time, the widgets only exist
+  // while the view is active.
+  TrashListModel *m_trashModel=nullptr;
+  TrashItemDelegate *m_trashDelegate=nullptr;
 
-  QVector<TrashItem*> m_trashItems;
-  QVector<TrashItem*> m_selectedTrashItems;
+  QListView *m_trashListView=nullptr;
+  QWidget *m_massActions=nullptr;
 
   QCheckBox *m_checkbox=nullptr;
   QToolButton *m_massRestore=nullptr;
@@ -49,7 +48,6 @@ private:
 
   // Private functions
   void toggleMassCheckmark(void);
-  void itemCheckedOrUncheckedOrRemoved(TrashItem *item);
 };
 
 #endif // TRASHVIEW_H
@@ -40,10 +40,10 @@ NoteListManager::NoteListManager(CustomListView *view, QWidget *noteListAddons,
           this, &NoteListManager::notebooksDeleted);
   connect(m_db->tagDatabase(), &TagDatabase::removed,
           this, &NoteListManager::tagDeleted);
-  connect(m_db->noteDatabase(), &NoteDatabase::noteChanged,
-          this, &NoteListManager::aNoteChanged);
   connect(m_db->noteDatabase(), &NoteDatabase::noteAdded,
           this, &NoteListManager::add_note);
+  connect(m_db->noteDatabase(), &NoteDatabase::notesAdded,
+          this, &NoteListManager::add_notes);
   connect(m_db->noteDatabase(), &NoteDatabase::noteFavoritedChanged,
           this, &NoteListManager::favoritedChanged);
   connect(m_db->noteDatabase(), &NoteDatabase::noteTrashedOrRestored,
@@ -85,6 +85,11 @@ NoteListItem *NoteListManager::add_note(Note *note)
   return i;
 }
 
+void NoteListManager::add_notes(QVector<Note*> notes)
+{
+  m_model->appendItems(notes);
+}
+
 void NoteListManager::remove_note(int index)
 {
   m_model->removeRows(index, 1);
@@ -108,10 +113,7 @@ void NoteListManager::loadNotesFromNoteDatabase()
 
 void NoteListManager::loadNotesFromNoteDatabase(NoteDatabase *noteDatabase)
 {
-  clear();
-  for (int i = 0; i < noteDatabase->size(); i++) {
-    add_note(noteDatabase->list()[i]);
-  }
+  m_model->setNotes( noteDatabase->list() );
 }
 
 void NoteListManager::openIndexInEditor(int index)
@@ -207,11 +209,7 @@ void NoteListManager::showFavoritesView()
   m_curViewType = View_Favorites;
   setTitle("Favorites");
 
-  int favCount = 0;
-  for ( Note *note : m_db->noteDatabase()->list() )
-    if ( note->favorited() )
-      favCount++;
-  setMetrics(favCount, "favorite note");
+  setMetrics(m_db->noteDatabase()->favoritedNotes().size(), "favorite note");
   clearFilter(false);
   m_proxyModel->setFavoritesFilterMode(NoteListProxyModel::FavoritesOnly);
 }
@@ -242,15 +240,8 @@ void NoteListManager::showNotebookView(Notebook *notebook)
 
   // Set the metricsLabel to the amount of notes the notebook
   // contains. It also checks with child notebook IDs.
-  QVector<QUuid> notebook_sync_hashes = {notebook->syncHash()};
-  QVector<Notebook*> children = notebook->recurseChildren();
-  int noteCount = 0;
-  for (Notebook *child : children)
-    notebook_sync_hashes.append( child->syncHash() );
-  for (Note *note : m_db->noteDatabase()->list() )
-    if ( notebook_sync_hashes.contains( note->notebook() ) )
-      noteCount++;
-  setMetrics(noteCount, "note");
+  QVector<QUuid> notebook_sync_hashes = m_db->notebookDatabase()->subtreeSyncHashes(notebook);
+  setMetrics(m_db->noteDatabase()->countNotesWithNotebookIDs(notebook_sync_hashes), "note");
 }
 
 void NoteListManager::showTagView(Tag *tag)
@@ -270,11 +261,7 @@ void NoteListManager::showTagView(Tag *tag)
 
   setTitle( tag->title() );
 
-  int tagCount = 0;
-  for ( Note *note : m_db->noteDatabase()->list() )
-    if ( note->tags().contains(tag->syncHash()) )
-      tagCount++;
-  setMetrics(tagCount, "note");
+  setMetrics(m_db->noteDatabase()->notesWithTag(tag->syncHash()).size(), "note");
 }
 
 void NoteListManager::showSearchQueryView(QString searchQuery)
@@ -391,14 +378,14 @@ void NoteListManager::favoritedChanged(void) {
   int favFilterMode = m_proxyModel->favoritesFilter();
   if ( favFilterMode == NoteListProxyModel::FavoritesOnly ||
        favFilterMode == NoteListProxyModel::FavoritesExclude )
-    m_proxyModel->invalidate();
+    scheduleProxyInvalidation();
 }
 
 void NoteListManager::trashedOrRestored(void) {
   int trashFilterMode = m_proxyModel->trashedFilter();
   if ( trashFilterMode == NoteListProxyModel::TrashHidden ||
        trashFilterMode == NoteListProxyModel::TrashOnly )
-    m_proxyModel->invalidate();
+    scheduleProxyInvalidation();
 }
 
 void NoteListManager::escribaDeselected() {
@@ -412,17 +399,6 @@ void NoteListManager::aNotebookChanged(Notebook* notebook) {
     showNotebookView(notebook);
 }
 
-void NoteListManager::aNoteChanged(Note* note) {
-  for (int i = 0; i < m_model->rowCount(); i++) {
-    QModelIndex index = m_model->index(i, 0);
-    Note *curNote = m_model->noteFromIndex(index);
-    if (curNote == note) {
-      m_model->refresh(i);
-      break;
-    }
-  }
-}
-
 void NoteListManager::aTagChanged(Tag* tag) {
   if ( m_curViewType == View_Tag && m_curViewType_Tag == tag )
     showTagView(tag);
@@ -431,3 +407,15 @@ void NoteListManager::aTagChanged(Tag* tag) {
 void NoteListManager::removeSearchQuery() {
   m_manager->treeManager()->removeSearchQuery();
 }
+
+void NoteListManager::scheduleProxyInvalidation() {
+  if ( m_proxyInvalidationPending )
+    return;
+  m_proxyInvalidationPending = true;
+  QMetaObject::invokeMethod(this, "invalidateProxyModel", Qt::QueuedConnection);
+}
+
+void NoteListManager::invalidateProxyModel() {
+  m_proxyInvalidationPending = false;
+  m_proxyModel->invalidate();
+}
@@ -32,6 +32,7 @@ public:
   NoteListAddonsWidget *addonsWidgetUi() const;
 
   NoteListItem *add_note(Note *note);
+  void add_notes(QVector<Note*> notes);
   void remove_note(int index);
   void clear();
   void filterOutEverything(bool shouldFilterOutEverything=true);
@@ -79,11 +80,11 @@ private slots:
   void escribaDeselected();
 
   // When a notebook or tag changes in the notebook/tag database
-  void aNoteChanged(Note *note);
   void aNotebookChanged(Notebook *notebook);
   void aTagChanged(Tag *tag);
 
   void removeSearchQuery();
+  void invalidateProxyModel();
 
 signals:
   void selectedNote(Note *note);
@@ -106,6 +107,10 @@ private:
   TrashView *m_trashView=nullptr;
 
   Database *m_db;
+
+  // Favoriting or trashing many notes at once only refilters the list once.
+  bool m_proxyInvalidationPending=false;
+  void scheduleProxyInvalidation();
 };
 
 #endif // NOTELISTMANAGER_H
@@ -205,6 +205,7 @@ void TreeManager::loadNotebookObjectAndChildren(Notebook *notebook, BasicTreeIte
 void TreeManager::loadNotebooksFromNotebookDatabase(NotebookDatabase *notebookDatabase, bool expandAll)
 {
   clearNotebooks();
+  BasicTreeItem::reservePool( notebookDatabase->listRecursively().size() );
   for (int i = 0; i < notebookDatabase->size(); i++) {
     loadNotebookObjectAndChildren(notebookDatabase->list()[i]);
   }
@@ -289,6 +290,7 @@ void TreeManager::clearTags()
 void TreeManager::loadTagsFromTagDatabase(TagDatabase *tagDatabase)
 {
   clearTags();
+  BasicTreeItem::reservePool( tagDatabase->size() );
   for (int i = 0; i < tagDatabase->size(); i++) {
     addTag(tagDatabase->list()[i]);
   }
@@ -7,12 +7,32 @@
 #define private public
 #include "../src/meta/note.h"
 #include "../src/sql/sqlmanager.h"
+#include "../src/meta/db/notedatabase.h"
+#include "../src/meta/db/notebookdatabase.h"
+#include "../src/meta/db/tagdatabase.h"
+#include "../src/meta/db/trigramindex.h"
+#include "../src/meta/db/notestore.h"
+#include "../src/meta/db/synchashinterner.h"
+#include "../src/meta/nodepool.h"
+#include "../src/models/sortfilter/notesearchengine.h"
+#include "../src/models/sortfilter/notelistproxymodel.h"
+#include "../src/models/notelistmodel.h"
+#include "../src/meta/db/database.h"
+#include "../src/models/sortfilter/fuzzymatcher.h"
+#include "../src/models/trashlistmodel.h"
 #include <helper-io.hpp>
+#define FTS_FUZZY_MATCH_IMPLEMENTATION
+#include <fts_fuzzy_match.hpp>
 #define private private
 
 #include <QtTest/qtest.h>
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QSignalSpy>
+#include <QPointer>
 #include <QDebug>
+#include <algorithm>
 
 class GenericTest : public QObject
 {
@@ -22,9 +42,34 @@ private slots:
   void numberToStringWord();
   void dateFormatting();
   void sqlmanager();
+  void bulkNoteLoading();
+  void lazyNoteText();
+  void saveQueue();
+  void storageThread();
+  void statementCache();
+  void statementCacheBenchmark_data();
+  void statementCacheBenchmark();
+  void schemaMigration();
+  void fullTextSearch();
+  void noteIndex();
+  void notebookSubtrees();
+  void notebookLoading();
+  void searchEngine();
+  void noteListSearch();
+  void fuzzyMatcher();
+  void fuzzyMatcherBenchmark_data();
+  void fuzzyMatcherBenchmark();
+  void trigramIndex();
+  void trashModel();
+  void noteStore();
+  void nodePool();
+  void tagLookup();
 
 private:
   QDateTime isoDate(QString str);
+  void resetTables(SQLManager &manager, bool legacySchema=false);
+  void populateNotes(SQLManager &manager, int count, int tagsPerNote=3);
+  QVector<QByteArray> titleCorpus(int count);
 
 };
 //void GenericTest::toUpper()
@@ -214,11 +259,1129 @@ void GenericTest::sqlmanager()
   delete newTag;
 }
 
+void GenericTest::bulkNoteLoading()
+{
+  SQLManager manager;
+
+  //
+  // Test: Tags are matched to the right notes
+  //
+  resetTables(manager);
+  populateNotes(manager, 10);
+  QVector<Note*> notes = manager.notes();
+  QCOMPARE(notes.length(), 10);
+  for (Note *note : notes) {
+    QCOMPARE(note->tags().length(), 3);
+    VariantList expected = manager.column( QString("select tag from notes_tags where note = '%1'").arg(note->syncHash().toString(QUuid::WithoutBraces)) );
+    for (QVariant tag : expected)
+      QVERIFY( note->tags().contains( QUuid(tag.toString()) ) );
+  }
+  qDeleteAll(notes);
+
+  //
+  // Test: A larger corpus loads every note with exactly its own tags
+  //
+  resetTables(manager);
+  populateNotes(manager, 2000);
+  notes = manager.notes();
+  QCOMPARE(notes.length(), 2000);
+  int tagLinks = 0;
+  QSet<QUuid> syncHashes;
+  for (Note *note : notes) {
+    QCOMPARE(note->tags().length(), 3);
+    tagLinks += note->tags().length();
+    syncHashes.insert(note->syncHash());
+  }
+  QCOMPARE(syncHashes.size(), 2000);
+  QCOMPARE(tagLinks, manager.column("select count(*) from notes_tags").first().toInt());
+  qDeleteAll(notes);
+
+  resetTables(manager);
+}
+
+void GenericTest::lazyNoteText()
+{
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 20, 0);
+
+  //
+  // Test: Metadata-only loading keeps an excerpt and fetches the text on demand
+  //
+  NoteDatabase db(&manager);
+  QCOMPARE(db.size(), 20);
+  for (Note *note : db.list())
+    QVERIFY( !note->textLoaded() );
+
+  Note *note = db.list().first();
+  QVERIFY( note->excerpt().startsWith("Body of note number") );
+  QCOMPARE( note->text(), manager.noteText(note->syncHash()) );
+  QVERIFY( note->textLoaded() );
+
+  //
+  // Test: The least recently used texts are dropped once over budget
+  //
+  qint64 noteCost = note->text().size() * static_cast<qint64>(sizeof(QChar));
+  db.setTextMemoryBudget(noteCost * 3);
+  for (Note *n : db.list())
+    n->text();
+  QVERIFY( db.textMemoryUsage() <= noteCost * 3 );
+  QVERIFY( db.list().last()->textLoaded() );
+  QVERIFY( !db.list().first()->textLoaded() );
+
+  //
+  // Test: Saving a note with unloaded text must not erase its text
+  //
+  Note *unloaded = db.list().first();
+  QString originalText = manager.noteText(unloaded->syncHash());
+  unloaded->setFavorited(true);
+  db.flushChanges();
+  QCOMPARE( manager.noteText(unloaded->syncHash()), originalText );
+
+  //
+  // Test: Adding a note with unloaded text doesn't ask for it
+  //
+  Note metadataOnly(QUuid::createUuid(), "Metadata only");
+  metadataOnly.unloadText();
+  QSignalSpy textRequested(&metadataOnly, &Note::textRequested);
+  QVERIFY( manager.addNote(&metadataOnly) );
+  QCOMPARE( textRequested.count(), 0 );
+
+  resetTables(manager);
+}
+
+void GenericTest::saveQueue()
+{
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 2, 0);
+  NoteDatabase db(&manager);
+
+  //
+  // Test: Changes to the same note are merged into a single write
+  //
+  Note *note = db.list().first();
+  QString query = QString("select title from notes where sync_hash = '%1'").arg(note->syncHash().toString(QUuid::WithoutBraces));
+  int writesBefore = db.saveQueue()->writeCount();
+  for (int i=1; i<=10; i++)
+    note->setTitle( QString("Typing %1").arg(i) );
+
+  QCOMPARE( db.saveQueue()->pendingCount(), 1 );
+  QVERIFY( db.saveQueue()->coalescedCount() >= 9 );
+  QVERIFY( manager.column(query).first().toString() != note->title() );
+
+  db.flushChanges();
+  QCOMPARE( db.saveQueue()->pendingCount(), 0 );
+  QCOMPARE( db.saveQueue()->writeCount(), writesBefore + 1 );
+  QCOMPARE( manager.column(query).first().toString(), QString("Typing 10") );
+
+  //
+  // Test: The queue flushes itself once idle
+  //
+  note->setTitle("Idle title");
+  QTRY_COMPARE_WITH_TIMEOUT( manager.column(query).first().toString(), QString("Idle title"), NOTE_SAVE_QUEUE_MAX_DELAY_MSECS );
+
+  //
+  // Test: Deleted notes are dropped from the queue
+  //
+  Note *other = db.list().last();
+  other->setTitle("Soon deleted");
+  db.removeNote(other);
+  QCOMPARE( db.saveQueue()->pendingCount(), 0 );
+
+  resetTables(manager);
+}
+
+void GenericTest::storageThread()
+{
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 50, 0);
+  manager.startStorageThread();
+  QVERIFY( manager.hasStorageThread() );
+
+  NoteDatabase db(&manager);
+  QSignalSpy committedSpy(&manager, &SQLManager::committed);
+
+  //
+  // Test: Mutations are committed in order and a barrier waits for all of them
+  //
+  for (Note *note : db.list()) {
+    note->setTitle("First pass");
+    manager.postUpdateNote(note);
+    note->setTitle("Second pass");
+    manager.postUpdateNote(note);
+  }
+  manager.barrier();
+  VariantList titles = manager.column("select distinct title from notes");
+  QCOMPARE( titles.length(), 1 );
+  QCOMPARE( titles.first().toString(), QString("Second pass") );
+
+  //
+  // Test: Completion signals are delivered back to the GUI thread
+  //
+  QTRY_VERIFY( committedSpy.count() >= db.size() * 2 );
+  quint64 lastTicket = 0;
+  for (QList<QVariant> args : committedSpy) {
+    QVERIFY( args.at(0).toULongLong() > lastTicket );
+    QVERIFY( args.at(1).toBool() );
+    lastTicket = args.at(0).toULongLong();
+  }
+
+  //
+  // Test: Deletes go through the same ordered queue
+  //
+  Note *note = db.list().first();
+  QString syncHash = note->syncHash().toString(QUuid::WithoutBraces);
+  db.removeNote(note);
+  manager.barrier();
+  QCOMPARE( manager.column(QString("select title from notes where sync_hash = '%1'").arg(syncHash)).length(), 0 );
+
+  db.flushChanges();
+  manager.stopStorageThread();
+  QVERIFY( !manager.hasStorageThread() );
+  resetTables(manager);
+}
+
+void GenericTest::statementCache()
+{
+  SQLManager manager;
+  resetTables(manager);
+
+  Note note;
+  note.setTitle("Cached Note");
+  note.setText("Hello world");
+  QVERIFY( manager.addNote(&note) );
+  QUuid tag = QUuid::createUuid();
+
+  //
+  // Test: A statement is prepared once, then the cached query is reused
+  //
+  manager.clearStatementCache();
+  QCOMPARE( manager.statementCacheSize(), 0 );
+  QVERIFY( manager.addTagToNote(note.syncHash(), tag, true) );
+  QCOMPARE( manager.statementCacheSize(), 1 );
+  int hits = manager.statementCacheHits();
+  QVERIFY( manager.removeTagFromNote(note.syncHash(), tag) );
+  QVERIFY( manager.addTagToNote(note.syncHash(), tag, true) );
+  QCOMPARE( manager.statementCacheSize(), 2 );
+  QCOMPARE( manager.statementCacheHits(), hits + 1 );
+  QCOMPARE( manager.noteTags(note.syncHash()).length(), 1 );
+
+  //
+  // Test: Clearing or disabling the cache prepares statements from scratch
+  //
+  manager.clearStatementCache();
+  QCOMPARE( manager.statementCacheSize(), 0 );
+  hits = manager.statementCacheHits();
+  manager.setStatementCacheEnabled(false);
+  for (int i=0; i<3; i++) {
+    QVERIFY( manager.removeTagFromNote(note.syncHash(), tag) );
+    QVERIFY( manager.addTagToNote(note.syncHash(), tag, true) );
+  }
+  QCOMPARE( manager.statementCacheSize(), 0 );
+  QCOMPARE( manager.statementCacheHits(), hits );
+  QCOMPARE( manager.noteTags(note.syncHash()).length(), 1 );
+  manager.setStatementCacheEnabled(true);
+
+  resetTables(manager);
+}
+
+void GenericTest::statementCacheBenchmark_data()
+{
+  QTest::addColumn<bool>("cached");
+  QTest::newRow("without cache") << false;
+  QTest::newRow("with cache") << true;
+}
+
+void GenericTest::statementCacheBenchmark()
+{
+  QFETCH(bool, cached);
+  SQLManager manager;
+  resetTables(manager);
+
+  Note note;
+  note.setTitle("Benchmark Note");
+  note.setText("Hello world");
+  QVERIFY( manager.addNote(&note) );
+  QUuid tag = QUuid::createUuid();
+
+  manager.setStatementCacheEnabled(cached);
+  QVERIFY( manager.realBasicQuery("BEGIN") );
+  QBENCHMARK {
+    manager.addTagToNote(note.syncHash(), tag);
+    manager.updateNoteToDB(&note);
+    manager.removeTagFromNote(note.syncHash(), tag);
+  }
+  QVERIFY( manager.realBasicQuery("COMMIT") );
+
+  resetTables(manager);
+}
+
 
 QDateTime GenericTest::isoDate(QString str)
 {
   return QDateTime::fromString(str, Qt::ISODate);
 }
 
+void GenericTest::schemaMigration()
+{
+  SQLManager manager;
+
+  //
+  // Test: Old databases are migrated and their sync hashes normalized
+  //
+  resetTables(manager, true);
+  QCOMPARE(manager.schemaVersion(), 0);
+  QVERIFY( manager.realBasicQuery("insert into notebooks (sync_hash, title) values ('{11111111-1111-1111-1111-111111111111}', 'Recipes')") );
+  QVERIFY( manager.realBasicQuery("insert into notes (sync_hash, title, notebook) values "
+                                  "('22222222-2222-2222-2222-222222222222', 'Pie', '{11111111-1111-1111-1111-111111111111}'), "
+                                  "('33333333-3333-3333-3333-333333333333', 'Loose', '{00000000-0000-0000-0000-000000000000}')") );
+  QVERIFY( manager.realBasicQuery("insert into notes_tags (note, tag) values "
+                                  "('{22222222-2222-2222-2222-222222222222}', '{44444444-4444-4444-4444-444444444444}'), "
+                                  "('22222222-2222-2222-2222-222222222222', '44444444-4444-4444-4444-444444444444')") );
+  QVERIFY( manager.migrate() );
+  QVERIFY( manager.schemaVersion() >= 1 );
+  QCOMPARE( manager.column("select title from notes where notebook = '11111111-1111-1111-1111-111111111111'").length(), 1 );
+  QCOMPARE( manager.column("select title from notes where notebook is null").length(), 1 );
+  QCOMPARE( manager.column("select tag from notes_tags").length(), 1 );
+  QCOMPARE( manager.noteTags(QUuid("22222222-2222-2222-2222-222222222222")).length(), 1 );
+
+  // Running it again is a no-op
+  QVERIFY( manager.migrate() );
+  QCOMPARE( manager.column("select title from notes").length(), 2 );
+
+  //
+  // Test: Looking up the notes of a tag uses the index, not a scan of notes_tags
+  //
+  resetTables(manager);
+  populateNotes(manager, 2000);
+  for (QVariant tag : manager.column("select tag from notes_tags limit 200"))
+    QCOMPARE( manager.column( QString("select note from notes_tags where tag = '%1'").arg(tag.toString()) ).length(), 1 );
+
+  VariantList plan = manager.column("EXPLAIN QUERY PLAN select note from notes_tags where tag = 'x'", 3);
+  QVERIFY( !plan.isEmpty() && plan.first().toString().contains("notes_tags_by_tag") );
+
+  resetTables(manager);
+}
+
+void GenericTest::fullTextSearch()
+{
+  SQLManager manager;
+  resetTables(manager);
+  if (!manager.hasFullTextSearch())
+    QSKIP("SQLite was built without FTS5");
+
+  QCOMPARE( SQLManager::fullTextQuery("  apple \"pie "), QString("\"apple\"* \"\"\"pie\"*") );
+
+  Note cake, pie, stew;
+  cake.setTitle("Cake");
+  cake.setText("Flour, sugar and a single apple.");
+  pie.setTitle("Apple pie");
+  pie.setText("Apples, apples and more apples.");
+  stew.setTitle("Stew");
+  stew.setText("Potatoes and carrots.");
+  for (Note *note : {&cake, &pie, &stew})
+    QVERIFY( manager.addNote(note) );
+
+  //
+  // Test: Ranked results with highlighted snippets
+  //
+  QVector<NoteSearchResult> results = manager.searchNotes("appl");
+  QCOMPARE(results.length(), 2);
+  QCOMPARE(results[0].syncHash, pie.syncHash());
+  QCOMPARE(results[1].syncHash, cake.syncHash());
+  QVERIFY( !results[1].highlights.isEmpty() );
+  QPair<int,int> highlight = results[1].highlights.first();
+  QCOMPARE( results[1].snippet.mid(highlight.first, highlight.second), QString("apple") );
+
+  //
+  // Test: Triggers keep the index in sync with the notes table
+  //
+  stew.setText("Potatoes, carrots and apple cider.");
+  QVERIFY( manager.updateNoteToDB(&stew) );
+  QCOMPARE(manager.searchNotes("cider").length(), 1);
+  QVERIFY( manager.realBasicQuery( QString("delete from notes where sync_hash = '%1'").arg(pie.syncHash().toString(QUuid::WithoutBraces)) ) );
+  QCOMPARE(manager.searchNotes("apple").length(), 2);
+  QVERIFY( manager.searchNotes("").isEmpty() );
+
+  //
+  // Test: The index still points at the right notes after a VACUUM
+  //
+  QVERIFY( manager.realBasicQuery("VACUUM") );
+  results = manager.searchNotes("cider");
+  QCOMPARE(results.length(), 1);
+  QCOMPARE(results[0].syncHash, stew.syncHash());
+
+  //
+  // Test: Searches limited to some notes, and mid-word matches
+  //
+  results = manager.searchNotesWithin("apple", {stew.syncHash()});
+  QCOMPARE(results.length(), 1);
+  QCOMPARE(results[0].syncHash, stew.syncHash());
+  QCOMPARE( manager.notesContaining("rrots", {cake.syncHash(), stew.syncHash()}),
+            QVector<QUuid>({stew.syncHash()}) );
+
+  resetTables(manager);
+}
+
+void GenericTest::noteIndex()
+{
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 50, 0);
+  NoteDatabase db(&manager);
+
+  //
+  // Test: Notes can be found by sync hash, and the index follows sync hash changes
+  //
+  Note *note = db.list().at(10);
+  QCOMPARE( db.findNoteWithSyncHash(note->syncHash()), note );
+  QUuid oldSyncHash = note->syncHash();
+  QUuid newSyncHash = QUuid::createUuid();
+  note->setSyncHash(newSyncHash);
+  QVERIFY( !db.noteWithSyncHashExists(oldSyncHash) );
+  QCOMPARE( db.findNoteWithSyncHash(newSyncHash), note );
+
+  //
+  // Test: Bulk removal keeps the list and index consistent
+  //
+  QVector<Note*> doomed = {db.list().at(0), db.list().at(20), db.list().at(49)};
+  QVector<QUuid> doomedSyncHashes;
+  for (Note *n : doomed)
+    doomedSyncHashes.append(n->syncHash());
+  QSignalSpy deleted(&db, &NoteDatabase::noteDeleted);
+  db.removeNotes(doomed);
+  QCOMPARE(db.size(), 47);
+  QCOMPARE(deleted.count(), 3);
+  for (QUuid syncHash : doomedSyncHashes)
+    QCOMPARE( db.findNoteWithSyncHash(syncHash), nullptr );
+  for (Note *n : db.list())
+    QCOMPARE( db.findNoteWithSyncHash(n->syncHash()), n );
+
+  //
+  // Test: Notebook, tag, favorite and trash sets follow the notes
+  //
+  QUuid notebook = QUuid::createUuid();
+  QUuid tag = QUuid::createUuid();
+  Note *first = db.list().at(0);
+  Note *second = db.list().at(1);
+  first->setNotebook(notebook);
+  second->setNotebook(notebook);
+  first->setTags({tag});
+  second->setFavorited(true);
+  second->setTrashed(true);
+  QCOMPARE( db.countNotesWithNotebookIDs({notebook, notebook}), 2 );
+  QCOMPARE( db.findNotesWithNotebookIDs({notebook}).length(), 2 );
+  QCOMPARE( db.notesWithTag(tag), QSet<Note*>({first}) );
+  QCOMPARE( db.favoritedNotes(), QSet<Note*>({second}) );
+  QCOMPARE( db.trashedNotes(), QSet<Note*>({second}) );
+
+  first->setNotebook(QUuid());
+  db.removeTagFromNotes(tag);
+  QVERIFY( first->tags().isEmpty() );
+  QCOMPARE( db.notesWithTag(tag).size(), 0 );
+  db.removeNote(second);
+  QCOMPARE( db.countNotesWithNotebookIDs({notebook}), 0 );
+  QVERIFY( db.favoritedNotes().isEmpty() );
+  QVERIFY( db.trashedNotes().isEmpty() );
+
+  //
+  // Test: Adding notes in bulk announces them once and keeps them newest first
+  //
+  QSignalSpy added(&db, &NoteDatabase::noteAdded);
+  QSignalSpy bulkAdded(&db, &NoteDatabase::notesAdded);
+  QVector<Note*> batch = {new Note(), new Note(), new Note()};
+  db.addNotes(batch, false);
+  QCOMPARE(added.count(), 0);
+  QCOMPARE(bulkAdded.count(), 1);
+  QCOMPARE(db.size(), 49);
+  QCOMPARE(db.list().at(0), batch.at(2));
+  QCOMPARE(db.list().at(2), batch.at(0));
+  QCOMPARE( db.findNoteWithSyncHash(batch.at(1)->syncHash()), batch.at(1) );
+
+  db.flushChanges();
+  resetTables(manager);
+}
+
+void GenericTest::notebookSubtrees()
+{
+  SQLManager manager;
+  resetTables(manager);
+  NoteDatabase noteDb(&manager);
+  NotebookDatabase notebookDb(&manager, &noteDb);
+
+  Notebook *recipes = new Notebook(QUuid::createUuid(), "Recipes");
+  Notebook *desserts = new Notebook(QUuid::createUuid(), "Desserts");
+  Notebook *pies = new Notebook(QUuid::createUuid(), "Pies");
+  Notebook *work = new Notebook(QUuid::createUuid(), "Work");
+  notebookDb.addNotebook(recipes, nullptr);
+  notebookDb.addNotebook(desserts, recipes);
+  notebookDb.addNotebook(pies, desserts);
+  notebookDb.addNotebook(work, nullptr);
+
+  //
+  // Test: Subtree membership
+  //
+  QVERIFY( notebookDb.notebookContains(recipes, pies->syncHash()) );
+  QVERIFY( notebookDb.notebookContains(desserts, desserts->syncHash()) );
+  QVERIFY( !notebookDb.notebookContains(desserts, recipes->syncHash()) );
+  QVERIFY( !notebookDb.notebookContains(work, pies->syncHash()) );
+  QCOMPARE( notebookDb.subtreeSyncHashes(recipes).length(), 3 );
+  QCOMPARE( notebookDb.findNotebookWithSyncHash(pies->syncHash()), pies );
+  QCOMPARE( notebookDb.listRecursively().length(), 5 ); // Including the Default Notebook
+
+  //
+  // Test: Moving a notebook updates its ancestors' subtrees
+  //
+  work->addChild(desserts);
+  QVERIFY( notebookDb.notebookContains(work, pies->syncHash()) );
+  QVERIFY( !notebookDb.notebookContains(recipes, pies->syncHash()) );
+  QCOMPARE( notebookDb.subtreeSyncHashes(recipes), QVector<QUuid>({recipes->syncHash()}) );
+
+  //
+  // Test: Notebooks can be looked up by interned id, unknown sync hashes match nothing
+  //
+  SyncHashInterner::Id piesId = syncHashInterner()->id(pies->syncHash());
+  QVERIFY( piesId != 0 );
+  QCOMPARE( syncHashInterner()->syncHash(piesId), pies->syncHash() );
+  QVERIFY( notebookDb.notebookContains(work, piesId) );
+  QVERIFY( !notebookDb.notebookContains(recipes, piesId) );
+  QVERIFY( !notebookDb.notebookContains(work, QUuid::createUuid()) );
+  QCOMPARE( notebookDb.findNotebookWithSyncHash(QUuid::createUuid()), nullptr );
+
+  //
+  // Test: A deleted notebook's id matches nothing, even once its memory is reused
+  //
+  notebookDb.removeNotebook(pies);
+  Notebook *tarts = new Notebook(QUuid::createUuid(), "Tarts");
+  notebookDb.addNotebook(tarts, desserts);
+  SyncHashInterner::Id tartsId = syncHashInterner()->intern(tarts->syncHash());
+  QVERIFY( !notebookDb.notebookContains(work, piesId) );
+  QVERIFY( !notebookDb.notebookContains(piesId, tartsId) );
+  QVERIFY( !notebookDb.notebookContains(piesId, piesId) );
+  QVERIFY( notebookDb.notebookContains(syncHashInterner()->id(work->syncHash()), tartsId) );
+
+  manager.barrier();
+  resetTables(manager);
+}
+
+void GenericTest::notebookLoading()
+{
+  SQLManager manager;
+  resetTables(manager);
+
+  // Rows are added out of order, and children before their parents.
+  Notebook recipes(QUuid::createUuid(), "Recipes", QDateTime::currentDateTime(), nullptr, 1);
+  Notebook work(QUuid::createUuid(), "Work", QDateTime::currentDateTime(), nullptr, 0);
+  Notebook pies(QUuid::createUuid(), "Pies", QDateTime::currentDateTime(), &recipes, 1);
+  Notebook cakes(QUuid::createUuid(), "Cakes", QDateTime::currentDateTime(), &recipes, 0);
+  Notebook apple(QUuid::createUuid(), "Apple", QDateTime::currentDateTime(), &pies, 0);
+  for (Notebook *notebook : {&apple, &pies, &cakes, &recipes, &work})
+    QVERIFY( manager.addNotebook(notebook) );
+
+  //
+  // Test: The whole forest is loaded in one go, ordered by row
+  //
+  QVector<Notebook*> roots = manager.notebooks();
+  QCOMPARE(roots.size(), 2);
+  QCOMPARE(roots[0]->title(), QString("Work"));
+  QCOMPARE(roots[1]->title(), QString("Recipes"));
+  QCOMPARE(roots[1]->children().size(), 2);
+  QCOMPARE(roots[1]->children()[0]->title(), QString("Cakes"));
+  Notebook *loadedPies = roots[1]->children()[1];
+  QCOMPARE(loadedPies->syncHash(), pies.syncHash());
+  QCOMPARE(loadedPies->parent(), roots[1]);
+  QCOMPARE(loadedPies->children().size(), 1);
+  QCOMPARE(loadedPies->children()[0]->syncHash(), apple.syncHash());
+  for (Notebook *root : roots) {
+    qDeleteAll(root->recurseChildren());
+    delete root;
+  }
+
+  //
+  // Test: Deleting a notebook takes its whole subtree and frees its notes
+  //
+  Note note;
+  note.setNotebook(apple.syncHash());
+  QVERIFY( manager.addNote(&note) );
+  manager.postDeleteNotebook(recipes.syncHash());
+  manager.barrier();
+  QCOMPARE( manager.column("SELECT sync_hash FROM notebooks").size(), 1 );
+  QVERIFY( manager.column(QString("SELECT notebook FROM notes WHERE sync_hash = '%1'")
+                          .arg(note.syncHash().toString(QUuid::WithoutBraces))).first().isNull() );
+
+  resetTables(manager);
+}
+
+void GenericTest::searchEngine()
+{
+  NoteSearchEngine engine;
+  QSignalSpy finished(&engine, &NoteSearchEngine::finished);
+
+  //
+  // Test: Small searches are scored right away and sorted best match first
+  //
+  QVector<NoteSearchEngine::Candidate> candidates = {
+    {QUuid::createUuid(), "Grocery list"},
+    {QUuid::createUuid(), "Groceries"},
+    {QUuid::createUuid(), "Meeting notes"},
+  };
+  engine.search("groc", candidates);
+  QCOMPARE(finished.count(), 1);
+  QVector<NoteSearchEngine::Result> results = finished.takeFirst().at(1).value<QVector<NoteSearchEngine::Result>>();
+  QCOMPARE(results.length(), 3);
+  QVERIFY( results[0].matched && results[1].matched && !results[2].matched );
+  QCOMPARE(results[2].syncHash, candidates[2].syncHash);
+
+  //
+  // Test: Search keys ignore case and diacritics, also outside of ASCII
+  //
+  QCOMPARE( HelperIO::searchKey(QString::fromUtf8("Élan ΣΟΦΊΑ")), QString::fromUtf8("elan σοφια").toUtf8() );
+  Note note;
+  note.setTitle(QString::fromUtf8("Café Menü"));
+  QCOMPARE( note.searchKey(), QByteArray("cafe menu") );
+  note.setTitle(QString::fromUtf8("Ωμέγα"));
+  engine.search(QString::fromUtf8("ΩΜΕΓ"), {{note.syncHash(), note.searchKey()}});
+  QVERIFY( finished.takeFirst().at(1).value<QVector<NoteSearchEngine::Result>>().first().matched );
+
+  //
+  // Test: Large searches run on the thread pool and stale ones are dropped
+  //
+  const int count = 100000;
+  candidates.clear();
+  for (int i = 0; i < count; i++)
+    candidates.append({QUuid::createUuid(), QString("Note number %1").arg(i).toUtf8()});
+
+  engine.search("nmbr 1", candidates);
+  engine.search("nmbr 12345", candidates);
+  QVERIFY( engine.isRunning() );
+  QTRY_COMPARE(finished.count(), 1);
+
+  QList<QVariant> arguments = finished.takeFirst();
+  QCOMPARE(arguments.at(0).toString(), QString("nmbr 12345"));
+  results = arguments.at(1).value<QVector<NoteSearchEngine::Result>>();
+  QCOMPARE(results.length(), count);
+  QVERIFY( results.first().matched );
+  for (int i = 1; i < results.length(); i++)
+    QVERIFY( results[i-1].matched > results[i].matched ||
+             (results[i-1].matched == results[i].matched && results[i-1].score >= results[i].score) );
+}
+
+void GenericTest::noteListSearch()
+{
+  SQLManager manager;
+  resetTables(manager);
+  if (!manager.hasFullTextSearch())
+    QSKIP("SQLite was built without FTS5");
+  NoteDatabase noteDb(&manager);
+  NotebookDatabase notebookDb(&manager, &noteDb);
+  TagDatabase tagDb(&manager);
+  Database db(&noteDb, &notebookDb, &tagDb);
+
+  Note *pie = noteDb.addNote(new Note(QUuid::createUuid(), "Apple pie", "Apples and more apples."));
+  Note *cake = noteDb.addNote(new Note(QUuid::createUuid(), "Cake", "Flour, sugar and a single apple."));
+  Note *stew = noteDb.addNote(new Note(QUuid::createUuid(), "Stew", "Potatoes and carrots."));
+
+  QListView view;
+  NoteListModel model(&view, &noteDb);
+  model.setNotes(noteDb.list());
+  NoteListProxyModel proxy(&view, &db);
+  proxy.setSourceModel(&model);
+  proxy.sort(0, Qt::DescendingOrder);
+
+  // There is no storage thread here and the library is small, so both
+  // halves of a search are in before setSearchQuery returns.
+
+  //
+  // Test: Title matches come before body matches
+  //
+  proxy.setSearchQuery("ap");
+  QCOMPARE( proxy.rowCount(), 2 );
+  QCOMPARE( proxy.item(0)->note(), pie );
+  QCOMPARE( proxy.item(1)->note(), cake );
+
+  //
+  // Test: Extending the query only searches the notes that matched before
+  //
+  QVERIFY( manager.realBasicQuery( QString("update notes set text = 'Apple cider' where sync_hash = '%1'")
+                                   .arg(stew->syncHash().toString(QUuid::WithoutBraces)) ) );
+  proxy.setSearchQuery("appl");
+  QCOMPARE( proxy.rowCount(), 2 ); // The stew isn't looked at again
+  proxy.setSearchQuery("APPLE");
+  QCOMPARE( proxy.rowCount(), 2 );
+
+  // Anything else searches every note.
+  proxy.setSearchQuery("cider");
+  QCOMPARE( proxy.rowCount(), 1 );
+  QCOMPARE( proxy.item(0)->note(), stew );
+
+  proxy.clearFilter();
+  QCOMPARE( proxy.rowCount(), 3 );
+  noteDb.flushChanges();
+  resetTables(manager);
+}
+
+void GenericTest::fuzzyMatcher()
+{
+  //
+  // Test: Same matches as fts::fuzzy_match, and never a worse score
+  // (FuzzyMatcher has no camel case bonus, so the corpus has no camel case)
+  //
+  int score = 0;
+  QVERIFY( FuzzyMatcher("").match("Anything", score) );
+  QVERIFY( FuzzyMatcher("GrLi").match("grocery list", score) );
+  QVERIFY( !FuzzyMatcher("list grocery").matches("grocery list") );
+
+  QVector<QByteArray> titles = titleCorpus(2000);
+  QVector<QByteArray> queries = {"gl", "meet", "rdlst", "travel plans", "xyz", "bdgt 2019"};
+
+  for (QByteArray query : queries) {
+    FuzzyMatcher matcher(query);
+    for (const QByteArray &title : titles) {
+      int expectedScore = 0;
+      bool expected = fts::fuzzy_match_simple(query.constData(), title.constData());
+      bool scored = fts::fuzzy_match(query.constData(), title.constData(), expectedScore);
+      QCOMPARE( matcher.match(title, score), expected );
+      if (scored)
+        QVERIFY( score >= expectedScore );
+    }
+  }
+}
+
+void GenericTest::fuzzyMatcherBenchmark_data()
+{
+  QTest::addColumn<bool>("fuzzyMatcher");
+  QTest::newRow("fts::fuzzy_match") << false;
+  QTest::newRow("FuzzyMatcher") << true;
+}
+
+void GenericTest::fuzzyMatcherBenchmark()
+{
+  QFETCH(bool, fuzzyMatcher);
+  QVector<QByteArray> titles = titleCorpus(50000);
+  QVector<QByteArray> queries = {"gl", "meet", "rdlst", "travel plans", "xyz", "bdgt 2019"};
+
+  int score = 0;
+  QBENCHMARK {
+    for (QByteArray query : queries) {
+      FuzzyMatcher matcher(query);
+      for (const QByteArray &title : titles) {
+        if (fuzzyMatcher)
+          matcher.match(title, score);
+        else
+          fts::fuzzy_match(query.constData(), title.constData(), score);
+      }
+    }
+  }
+}
+
+void GenericTest::trigramIndex()
+{
+  //
+  // Test: Candidates contain every trigram, removed documents are skipped
+  //
+  TrigramIndex index;
+  TrigramIndex::DocId grocery = index.add("grocery list");
+  TrigramIndex::DocId groceries = index.add("groceries");
+  TrigramIndex::DocId meeting = index.add("meeting notes");
+  QCOMPARE( index.candidates("ocer"), QVector<TrigramIndex::DocId>({grocery, groceries}) );
+  QCOMPARE( index.candidates("ting"), QVector<TrigramIndex::DocId>({meeting}) );
+  QVERIFY( index.candidates("xyz").isEmpty() );
+  QCOMPARE( index.candidates("gr").length(), 3 );
+  index.remove(grocery);
+  QCOMPARE( index.candidates("ocer"), QVector<TrigramIndex::DocId>({groceries}) );
+
+  //
+  // Test: Compaction drops removed ids a few posting lists at a time
+  //
+  QCOMPARE( index.removedCount(), 1 );
+  index.compact(1);
+  QCOMPARE( index.removedCount(), 1 );
+  while ( index.removedCount() > 0 )
+    index.compact(1);
+  QCOMPARE( index.candidates("ocer"), QVector<TrigramIndex::DocId>({groceries}) );
+  QCOMPARE( index.candidates("gr").length(), 2 );
+
+  //
+  // Test: Substring search over note titles and bodies
+  //
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 100, 0);
+  NoteDatabase db(&manager);
+  QCOMPARE( db.findNotesContaining("UMBER 42").length(), 1 );
+  Note *note = db.list().first();
+  note->setTitle(QString::fromUtf8("Crème brûlée"));
+  QCOMPARE( db.findNotesContaining("brulee").first(), note );
+  int removed = db.trigramIndex().removedCount();
+  for (QString text : {"C", "Ca", "Car", "Caramelized sugar"})
+    note->setText(text);
+  QCOMPARE( db.findNotesContaining("melized").first(), note );
+  QVERIFY( db.trigramIndex().removedCount() <= removed + 1 ); // Re-indexed once, not per edit
+  db.removeNote(note);
+  QVERIFY( db.findNotesContaining("melized").isEmpty() );
+
+  //
+  // Test: Body searches see pending edits and report mid-word matches
+  //
+  QSignalSpy bodySearches(&db, &NoteDatabase::bodySearchFinished);
+  Note *butter = db.list().first();
+  butter->setText("Unsalted butter");
+  db.postBodySearch("salted");
+  QTRY_COMPARE( bodySearches.count(), 1 );
+  QList<QVariant> arguments = bodySearches.takeFirst();
+  QCOMPARE( arguments.at(0).toString(), QString("salted") );
+  NoteBodySearch found = arguments.at(1).value<NoteBodySearch>();
+  QVERIFY( found.ranked.isEmpty() ); // Not a word prefix
+  QCOMPARE( found.containing, QVector<QUuid>({butter->syncHash()}) );
+  db.postBodySearch("salted", QVector<QUuid>());
+  QTRY_COMPARE( bodySearches.count(), 1 );
+  QVERIFY( bodySearches.takeFirst().at(1).value<NoteBodySearch>().containing.isEmpty() );
+  db.flushChanges();
+
+  //
+  // Test: Every document containing the query is among the candidates
+  //
+  QStringList words = {"meeting", "notes", "grocery", "list", "project", "ideas", "recipe",
+                       "budget", "travel", "plans", "journal", "todo", "reading", "summary",
+                       "kubernetes", "birthday", "invoice", "quarterly", "apartment", "garden"};
+  qsrand(7);
+  TrigramIndex corpus;
+  QVector<QByteArray> keys;
+  for (int i = 0; i < 500; i++) {
+    QStringList body;
+    for (int w = 0, count = 5 + qrand() % 20; w < count; w++)
+      body.append( words.at(qrand() % words.length()) );
+    keys.append( HelperIO::searchKey(body.join(" ")) );
+    corpus.add(keys.last());
+  }
+
+  for (QString query : {"uarter", "bernet", "invoice garden", "eeting not"}) {
+    QByteArray key = HelperIO::searchKey(query);
+    QVector<TrigramIndex::DocId> candidates = corpus.candidates(key);
+    for (int i = 0; i < keys.length(); i++)
+      if ( keys[i].contains(key) )
+        QVERIFY( std::binary_search(candidates.begin(), candidates.end(), TrigramIndex::DocId(i)) );
+  }
+  QVERIFY( corpus.candidates("zebra").isEmpty() );
+
+  resetTables(manager);
+}
+
+void GenericTest::trashModel()
+{
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 20, 0);
+  NoteDatabase db(&manager);
+  QList<Note*> notes = db.list();
+  for (int i=0; i<10; i++)
+    notes.at(i)->setTrashed(true);
+  db.flushChanges();
+
+  //
+  // Test: The model is filled from the trashed notes, newest first
+  //
+  TrashListModel model(&db);
+  QCOMPARE(model.rowCount(), 10);
+  for (int i=1; i<model.rowCount(); i++)
+    QVERIFY( model.noteFromIndex(model.index(i-1))->dateCreated() >=
+             model.noteFromIndex(model.index(i))->dateCreated() );
+  for (int i=0; i<10; i++)
+    QCOMPARE( model.noteFromIndex(model.indexOfNote(notes.at(i))), notes.at(i) );
+  QVERIFY( !model.indexOfNote(notes.at(15)).isValid() );
+
+  //
+  // Test: It follows notes being trashed, restored and deleted
+  //
+  notes.at(15)->setTrashed(true);
+  QCOMPARE(model.rowCount(), 11);
+  QCOMPARE( model.noteFromIndex(model.indexOfNote(notes.at(15))), notes.at(15) );
+
+  QItemSelection selection;
+  selection.select(model.index(0), model.index(3));
+  selection.select(model.index(8), model.index(8));
+  QVector<Note*> selected = model.notesInSelection(selection);
+  QCOMPARE(selected.size(), 5);
+  QCOMPARE(selected.first(), model.noteFromIndex(model.index(0)));
+
+  //
+  // Test: Bulk restore and delete each go to SQL as a single mutation
+  //
+  QSignalSpy committed(&manager, &SQLManager::committed);
+  db.restoreNotes(selected.mid(0, 2));
+  QCOMPARE(committed.count(), 1);
+  QCOMPARE(model.rowCount(), 9);
+  QCOMPARE( db.saveQueue()->pendingCount(), 0 );
+  QVERIFY( !selected.at(0)->trashed() );
+
+  QString trashedQuery = QString("select trashed from notes where sync_hash = '%1'")
+                           .arg(selected.at(0)->syncHash().toString(QUuid::WithoutBraces));
+  QCOMPARE( manager.column(trashedQuery).first().toInt(), 0 );
+
+  committed.clear();
+  QSignalSpy rowsRemoved(&model, &TrashListModel::rowsRemoved);
+  QSignalSpy modelReset(&model, &TrashListModel::modelReset);
+  db.removeNotes(selected.mid(2));
+  QCOMPARE(committed.count(), 1);
+  QCOMPARE(model.rowCount(), 6);
+  QCOMPARE( manager.column("select count(*) from notes").first().toInt(), 17 );
+  QCOMPARE(modelReset.count(), 1); // Scattered rows, removed in one pass
+  QCOMPARE(rowsRemoved.count(), 0);
+
+  //
+  // Test: Emptying the trash removes every row at once
+  //
+  QVector<Note*> trash;
+  for (int i=0; i<model.rowCount(); i++)
+    trash.append( model.noteFromIndex(model.index(i)) );
+  db.removeNotes(trash);
+  QCOMPARE(model.rowCount(), 0);
+  QCOMPARE(rowsRemoved.count(), 1);
+  QCOMPARE(modelReset.count(), 1);
+
+  resetTables(manager);
+}
+
+void GenericTest::noteStore()
+{
+  SQLManager manager;
+  resetTables(manager);
+  populateNotes(manager, 30, 2);
+  NoteDatabase db(&manager);
+  const NoteStore &store = db.store();
+
+  //
+  // Test: Every note has a row holding its title, dates, notebook, tags and flags
+  //
+  QCOMPARE(store.size(), 30);
+  for (Note *note : db.list()) {
+    NoteStore::Row row = db.storeRow(note);
+    QCOMPARE( store.note(row), note );
+    QCOMPARE( store.title(row), note->title() );
+    QCOMPARE( store.dateCreated(row), note->dateCreated().toMSecsSinceEpoch() );
+    QCOMPARE( store.dateModified(row), note->dateModified().toMSecsSinceEpoch() );
+    QCOMPARE( syncHashInterner()->syncHash(store.notebook(row)), note->notebook() );
+    for (QUuid tag : note->tags())
+      QVERIFY( store.hasTag(row, syncHashInterner()->id(tag)) );
+  }
+
+  //
+  // Test: Rows follow changes, and changed rows are announced once per turn
+  //
+  QSignalSpy rowsChanged(&db, &NoteDatabase::rowsChanged);
+  Note *note = db.list().at(3);
+  NoteStore::Row row = db.storeRow(note);
+  QUuid notebook = QUuid::createUuid();
+  QUuid tag = QUuid::createUuid();
+  note->setTitle("Moved");
+  note->setFavorited(true);
+  note->setTrashed(true);
+  note->setNotebook(notebook);
+  note->setTags({tag});
+  QCOMPARE( store.title(row), QString("Moved") );
+  QVERIFY( store.favorited(row) );
+  QVERIFY( store.trashed(row) );
+  QVERIFY( !store.encrypted(row) );
+  QCOMPARE( syncHashInterner()->syncHash(store.notebook(row)), notebook );
+  QVERIFY( store.hasTag(row, syncHashInterner()->id(tag)) );
+  QCOMPARE( syncHashInterner()->id(QUuid::createUuid()), NoteStore::Id(0) );
+
+  QTRY_COMPARE(rowsChanged.count(), 1);
+  QCOMPARE( rowsChanged.first().first().value<QVector<NoteStore::Row>>(), QVector<NoteStore::Row>({row}) );
+
+  //
+  // Test: Notes outside the store hold their own fields, and get them back when removed
+  //
+  Note loose(QUuid::createUuid(), "Loose");
+  QCOMPARE( db.storeRow(&loose), NoteStore::Row(NOTE_STORE_NO_ROW) );
+  NoteStore looseStore;
+  NoteStore::Row looseRow = looseStore.insert(&loose, {});
+  QCOMPARE( db.storeRow(&loose), NoteStore::Row(NOTE_STORE_NO_ROW) );
+  loose.setTitle("Still loose");
+  loose.setFavorited(true);
+  QCOMPARE( looseStore.title(looseRow), QString("Still loose") );
+  QVERIFY( looseStore.favorited(looseRow) );
+  looseStore.remove(looseRow);
+  QCOMPARE( looseStore.row(&loose), NoteStore::Row(NOTE_STORE_NO_ROW) );
+  QCOMPARE( loose.title(), QString("Still loose") );
+  QVERIFY( loose.favorited() );
+
+  //
+  // Test: Rows of deleted notes are reused
+  //
+  db.removeNote(note);
+  QCOMPARE(store.size(), 29);
+  QCOMPARE( store.note(row), nullptr );
+  Note *added = db.addNote(new Note(), false);
+  QCOMPARE( db.storeRow(added), row );
+  QCOMPARE(store.capacity(), 30);
+  QVERIFY( store.memoryUsage() > 0 );
+
+  db.flushChanges();
+  resetTables(manager);
+}
+
+void GenericTest::nodePool()
+{
+  NodePool pool(sizeof(Notebook), 4);
+
+  //
+  // Test: Reserved blocks are handed out front to back from one chunk
+  //
+  pool.reserve(10);
+  QCOMPARE(pool.capacity(), 12);
+  QVector<char*> blocks;
+  for (int i = 0; i < 10; i++)
+    blocks.append( static_cast<char*>(pool.allocate()) );
+  for (int i = 1; i < blocks.size(); i++)
+    QVERIFY( blocks[i] > blocks[i-1] );
+  QCOMPARE( blocks.last() - blocks.first(), std::ptrdiff_t(9 * (blocks[1] - blocks[0])) );
+  QCOMPARE(pool.liveCount(), 10);
+
+  //
+  // Test: Freed blocks are reused, the memory only goes on release()
+  //
+  pool.deallocate(blocks[4]);
+  QCOMPARE( static_cast<char*>(pool.allocate()), blocks[4] );
+  blocks.append( static_cast<char*>(pool.allocate()) );
+  QCOMPARE(pool.capacity(), 12);
+  QCOMPARE(pool.liveCount(), 11);
+
+  //
+  // Test: Small reserves grow the pool by whole chunks
+  //
+  pool.reserve(1);
+  QCOMPARE(pool.capacity(), 12);
+  pool.reserve(3);
+  QCOMPARE(pool.capacity(), 16);
+
+  while ( pool.liveCount() > 1 )
+    pool.deallocate(blocks.takeLast());
+  QVERIFY( !pool.release() );
+  QCOMPARE(pool.capacity(), 16);
+  pool.deallocate(blocks.takeLast());
+  QCOMPARE(pool.capacity(), 16);
+  QVERIFY( pool.release() );
+  QCOMPARE(pool.capacity(), 0);
+
+  //
+  // Test: Clearing notebooks frees whole trees, not just the top level
+  //
+  SQLManager manager;
+  resetTables(manager);
+  NoteDatabase noteDb(&manager);
+  NotebookDatabase notebookDb(&manager, &noteDb);
+  Notebook *parent = new Notebook(QUuid::createUuid(), "Parent");
+  QPointer<Notebook> child = new Notebook(QUuid::createUuid(), "Child");
+  notebookDb.addNotebook(parent);
+  notebookDb.addNotebook(child, parent);
+  QCOMPARE(notebookDb.listRecursively().size(), 3);
+  notebookDb.clearNotebooks();
+  QCOMPARE(notebookDb.listRecursively().size(), 1); // The Default Notebook stays
+  QVERIFY( child.isNull() );
+
+  manager.barrier();
+  resetTables(manager);
+}
+
+void GenericTest::tagLookup()
+{
+  SQLManager manager;
+  resetTables(manager);
+  TagDatabase db(&manager);
+
+  //
+  // Test: Titles are matched regardless of case, duplicates are rejected
+  //
+  Tag *groceries = db.addTag("Groceries");
+  QCOMPARE( db.addTag("GROCERIES"), groceries );
+  QCOMPARE( db.findTagWithName("groceries"), groceries );
+  QCOMPARE( db.findTagWithName("Work"), nullptr );
+  QCOMPARE( db.findTagWithSyncHash(groceries->syncHash()), groceries );
+  QCOMPARE( db.size(), 1 );
+
+  //
+  // Test: Renaming a tag moves it to its new title
+  //
+  groceries->setTitle("Shopping");
+  QCOMPARE( db.findTagWithName("groceries"), nullptr );
+  QCOMPARE( db.findTagWithName("SHOPPING"), groceries );
+  QCOMPARE( db.addTag("Groceries")->title(), QString("Groceries") );
+  QCOMPARE( db.size(), 2 );
+
+  //
+  // Test: Tags reloaded from SQL keep the first of each title
+  //
+  manager.barrier();
+  Tag duplicate(QUuid::createUuid(), "shopping");
+  QVERIFY( manager.addTag(&duplicate) );
+  TagDatabase reloaded(&manager);
+  QCOMPARE( reloaded.size(), 2 );
+  QVERIFY( reloaded.findTagWithName("Shopping") != nullptr );
+
+  db.clearTags();
+  QCOMPARE( db.findTagWithName("Shopping"), nullptr );
+  manager.barrier();
+  resetTables(manager);
+}
+
+
+// Recreates the tables from create.sql, migrated to the latest schema unless
+// legacySchema is set.
+void GenericTest::resetTables(SQLManager &manager, bool legacySchema)
+{
+  QStringList tables = {"notes_fts", "notes", "notebooks", "tags", "notes_tags"};
+  for (QString t : tables)
+    QVERIFY( manager.realBasicQuery( QString("drop table if exists %1").arg(t) ) );
+  QVERIFY( manager.realBasicQuery("PRAGMA user_version = 0") );
+  QVERIFY( manager.runScript(":sql/create.sql") );
+  if (!legacySchema)
+    QVERIFY( manager.migrate() );
+}
+
+// Synthetic note titles made of common words, without camel case.
+QVector<QByteArray> GenericTest::titleCorpus(int count)
+{
+  QStringList words = {"meeting", "notes", "Grocery", "list", "project", "Ideas", "recipe",
+                       "budget", "2019", "travel", "plans", "journal", "todo", "reading_list"};
+  QVector<QByteArray> titles;
+  qsrand(42);
+  for (int i = 0; i < count; i++) {
+    QStringList title;
+    for (int w = 0, length = 2 + qrand() % 5; w < length; w++)
+      title.append( words.at(qrand() % words.length()) );
+    titles.append( title.join(" ").toUtf8() );
+  }
+  return titles;
+}
+
+// Fills the database with a synthetic library of notes, each linked to a few tags.
+void GenericTest::populateNotes(SQLManager &manager, int count, int tagsPerNote)
+{
+  QSqlQuery noteQ;
+  QSqlQuery tagQ;
+  noteQ.prepare("insert into notes (sync_hash, title, text, date_created, date_modified, favorited, encrypted, trashed) "
+                "values (:sync_hash, :title, :text, :date, :date, 0, 0, 0)");
+  tagQ.prepare("insert into notes_tags (note, tag) values (:note, :tag)");
+
+  QVERIFY( manager.realBasicQuery("BEGIN") );
+  for (int i=0; i<count; i++) {
+    QString syncHash = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    noteQ.bindValue(":sync_hash", syncHash);
+    noteQ.bindValue(":title", QString("Note %1").arg(i));
+    noteQ.bindValue(":text", QString("Body of note number %1").arg(i));
+    noteQ.bindValue(":date", QDateTime::currentDateTime());
+    noteQ.exec();
+    for (int j=0; j<tagsPerNote; j++) {
+      tagQ.bindValue(":note", syncHash);
+      tagQ.bindValue(":tag", QUuid::createUuid().toString(QUuid::WithoutBraces));
+      tagQ.exec();
+    }
+  }
+  QVERIFY( manager.realBasicQuery("COMMIT") );
+}
+
 QTEST_MAIN(GenericTest)
 #include "unit-tests.moc"